@@ -8,8 +8,10 @@
 #pragma once
 #include <stdio.h>
 #include <stdlib.h>
+#if defined(_WIN32)
 #include <winnt.h>
 #include "windows.h"
+#endif
 
 typedef unsigned int UINT;
 typedef int INT;
@@ -21,7 +23,8 @@ enum INT
 };
 
 /*
- * the windows' signal function used in multi-tasks
+ * the windows' signal function used in multi-tasks, algo_linux.h has the same
+ * macros built on futex and pthread
  */
 #if defined(_WIN32)
 #define	LOCK		HANDLE
@@ -42,6 +45,67 @@ enum INT
 #define SemaWait(x)			WaitForSingleObject(x,INFINITE)
 #define SemaRelease(x,y)	ReleaseSemaphore(x,y,NULL)
 #define SemaClose(x)		CloseHandle(x)
+
+#define THREAD				HANDLE
+#define THREADRET			DWORD
+#define THREADAPI			WINAPI
+#define ThreadCreate(f,x)	CreateThread(NULL,0,(f),(x),0,NULL)
+#define ThreadJoin(x)		(void)WaitForSingleObject((x), INFINITE)
+#define ThreadClose(x)		(void)CloseHandle(x)
+#define ThreadYield()		(void)SwitchToThread()
+#else
+#include "algo_linux.h"
+#endif
+
+/*
+ * the atomic operations used in multi-tasks, they are full memory barriers
+ */
+#if defined(_MSC_VER)
+#define AtomicIncrement(p)	InterlockedIncrement(p)
+#define AtomicDecrement(p)	InterlockedDecrement(p)
+#else
+#define AtomicIncrement(p)	__atomic_add_fetch((p), 1, __ATOMIC_SEQ_CST)
+#define AtomicDecrement(p)	__atomic_sub_fetch((p), 1, __ATOMIC_SEQ_CST)
+#endif
+
+/*
+ * the 64-bit atomic operations, AtomicCas64 replaces *p by n if it is o and
+ * returns nonzero if succeeded, the load is acquire and the store is release
+ */
+#if defined(_MSC_VER)
+#define AtomicCas64(p, o, n)	(InterlockedCompareExchange64((volatile LONG64 *)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#define AtomicLoad64(p)			((UINT64)InterlockedCompareExchange64((volatile LONG64 *)(p), 0, 0))
+#define AtomicStore64(p, v)		(void)InterlockedExchange64((volatile LONG64 *)(p), (LONG64)(v))
+#else
+#define AtomicCas64(p, o, n)	__sync_bool_compare_and_swap((p), (o), (n))
+#define AtomicLoad64(p)			__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define AtomicStore64(p, v)		__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+/*
+ * the 32-bit atomic operations like the 64-bit ones, AtomicFence is a full
+ * memory barrier
+ */
+#if defined(_MSC_VER)
+#define AtomicCas32(p, o, n)	(InterlockedCompareExchange((volatile LONG *)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#define AtomicLoad32(p)			((UINT)InterlockedCompareExchange((volatile LONG *)(p), 0, 0))
+#define AtomicStore32(p, v)		(void)InterlockedExchange((volatile LONG *)(p), (LONG)(v))
+#define AtomicFence()			MemoryBarrier()
+#else
+#define AtomicCas32(p, o, n)	__sync_bool_compare_and_swap((p), (o), (n))
+#define AtomicLoad32(p)			__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define AtomicStore32(p, v)		__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define AtomicFence()			__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/*
+ * fetch the cache line of address p into cache, it never faults
+ */
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define Prefetch(p)			_mm_prefetch((const char *)(p), _MM_HINT_T0)
+#else
+#define Prefetch(p)			__builtin_prefetch(p)
 #endif
 
 /*
@@ -90,6 +154,14 @@ typedef void*(*COPYFUNC) (void *pData);
  */
 typedef UINT(*GETKEYFUNC) (void *pData, UINT uKeyIndex);
 
+/*
+ * The function of access the whole keyword as an unsigned integer, the order of
+ * returned values must be the same as the order of data
+ * @param void *pData -- the keyword's pointer
+ * @return UINT64 -- the keyword
+ */
+typedef UINT64(*GETKEY64FUNC) (void *pData);
+
 /*
  * The callback function of calculate hash value
  * @param void *pKey -- the keyword that need to calculate hash value
@@ -0,0 +1,313 @@
+/*********************************************************************************
+ * FileName:	algo_linux.h
+ * Author:		gehan
+ * Date:		07/22/2017
+ * Description: The Linux version of the windows' types and signal functions used
+ *				in algo.h, the lock, event and semaphore are built on futex so that
+ *				they stay in user space when nobody waits, and the thread is built
+ *				on pthread. It is included by algo.h, don't include it directly
+**********************************************************************************/
+
+#pragma once
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+typedef int					BOOL;
+typedef unsigned char		BYTE;
+typedef unsigned short		WORD;
+typedef unsigned int		DWORD;
+typedef int					LONG;
+typedef long long			LONG64;
+typedef void *				HANDLE;
+typedef short				INT16;
+typedef unsigned short		UINT16;
+typedef int					INT32;
+typedef unsigned int		UINT32;
+typedef long long			INT64;
+typedef unsigned long long	UINT64;
+
+#ifndef TRUE
+#define TRUE				1
+#endif
+#ifndef FALSE
+#define FALSE				0
+#endif
+
+#define FUTEX_SPIN_MAX		100		/*the max times of spinning before sleep*/
+
+#if defined(__i386__) || defined(__x86_64__)
+#define FUTEX_PAUSE()		__builtin_ia32_pause()
+#else
+#define FUTEX_PAUSE()		__asm__ __volatile__("" ::: "memory")
+#endif
+
+/*
+ * the lock state is 0 if unlocked, 1 if locked and 2 if locked and some thread
+ * may sleep on it, so the unlock only calls futex when the state is 2
+ */
+typedef struct FUTEXLOCK_st{
+	volatile INT nState;
+	INT nSpin;		/*the average times of spinning, it is a hint*/
+	INT nSpinMax;	/*0 on one cpu, the owner can't release lock while we spin*/
+}FUTEXLOCK;
+
+/*
+ * the manual-reset event, nSignaled never goes back to 0
+ */
+typedef struct FUTEXEVENT_st{
+	volatile INT nSignaled;
+}FUTEXEVENT;
+
+typedef struct FUTEXSEMA_st{
+	volatile INT nCount;
+	volatile INT nWaiters;	/*the count of threads which may sleep on nCount*/
+	INT nMaxCount;
+}FUTEXSEMA;
+
+typedef struct FUTEXTHREAD_st{
+	pthread_t Thread;
+}FUTEXTHREAD;
+
+static inline void Futex_Wait(volatile INT *pAddr, INT nValue)
+{
+	(void)syscall(SYS_futex, pAddr, FUTEX_WAIT_PRIVATE, nValue, NULL, NULL, 0);
+}
+
+static inline void Futex_Wake(volatile INT *pAddr, INT nCount)
+{
+	(void)syscall(SYS_futex, pAddr, FUTEX_WAKE_PRIVATE, nCount, NULL, NULL, 0);
+}
+
+/*
+ * create a lock
+ * @return FUTEXLOCK * if successfully or return NULL if fail
+ */
+static inline FUTEXLOCK *Futex_LockCreate(void)
+{
+	FUTEXLOCK *pLock = (FUTEXLOCK *)malloc(sizeof(FUTEXLOCK));
+	if (pLock != NULL)
+	{
+		pLock->nState = 0;
+		pLock->nSpin = 0;
+		pLock->nSpinMax = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? FUTEX_SPIN_MAX : 0;
+	}
+	return pLock;
+}
+
+/*
+ * get the lock, it spins a while if the lock is held and then sleeps, the times
+ * of spinning follows the average times it took to get the lock before
+ * @param FUTEXLOCK *pLock
+ * @return void
+ */
+static inline void Futex_Lock(FUTEXLOCK *pLock)
+{
+	INT nState = 0;
+	INT nSpin;
+	INT nLimit;
+	INT i;
+	if (__atomic_compare_exchange_n(&pLock->nState, &nState, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	{
+		return;
+	}
+	nSpin = __atomic_load_n(&pLock->nSpin, __ATOMIC_RELAXED);
+	nLimit = nSpin * 2 + 10;
+	if (nLimit > pLock->nSpinMax)
+	{
+		nLimit = pLock->nSpinMax;
+	}
+	for (i = 0; i < nLimit; ++i)
+	{
+		FUTEX_PAUSE();
+		nState = 0;
+		if (0 == __atomic_load_n(&pLock->nState, __ATOMIC_RELAXED)
+			&& __atomic_compare_exchange_n(&pLock->nState, &nState, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		{
+			__atomic_store_n(&pLock->nSpin, nSpin + (i - nSpin) / 8, __ATOMIC_RELAXED);
+			return;
+		}
+	}
+	/*mark the lock as contended, so the owner wakes us when unlocking*/
+	while (__atomic_exchange_n(&pLock->nState, 2, __ATOMIC_ACQUIRE) != 0)
+	{
+		Futex_Wait(&pLock->nState, 2);
+	}
+	__atomic_store_n(&pLock->nSpin, nSpin + (nLimit - nSpin) / 8, __ATOMIC_RELAXED);
+}
+
+/*
+ * release the lock
+ * @param FUTEXLOCK *pLock
+ * @return void
+ */
+static inline void Futex_Unlock(FUTEXLOCK *pLock)
+{
+	if (2 == __atomic_exchange_n(&pLock->nState, 0, __ATOMIC_RELEASE))
+	{
+		Futex_Wake(&pLock->nState, 1);
+	}
+}
+
+/*
+ * create a manual-reset event which is not signaled
+ * @return FUTEXEVENT * if successfully or return NULL if fail
+ */
+static inline FUTEXEVENT *Futex_EventCreate(void)
+{
+	FUTEXEVENT *pEvent = (FUTEXEVENT *)malloc(sizeof(FUTEXEVENT));
+	if (pEvent != NULL)
+	{
+		pEvent->nSignaled = 0;
+	}
+	return pEvent;
+}
+
+/*
+ * wait until the event is signaled
+ * @param FUTEXEVENT *pEvent
+ * @return void
+ */
+static inline void Futex_WaitEvent(FUTEXEVENT *pEvent)
+{
+	while (0 == __atomic_load_n(&pEvent->nSignaled, __ATOMIC_ACQUIRE))
+	{
+		Futex_Wait(&pEvent->nSignaled, 0);
+	}
+}
+
+/*
+ * signal the event and wake all waiting threads
+ * @param FUTEXEVENT *pEvent
+ * @return void
+ */
+static inline void Futex_SendEvent(FUTEXEVENT *pEvent)
+{
+	if (0 == __atomic_exchange_n(&pEvent->nSignaled, 1, __ATOMIC_RELEASE))
+	{
+		Futex_Wake(&pEvent->nSignaled, INT_MAX);
+	}
+}
+
+/*
+ * create a semaphore
+ * @param INT nInitCount -- the initial count
+ * @param INT nMaxCount -- the max count
+ * @return FUTEXSEMA * if successfully or return NULL if fail
+ */
+static inline FUTEXSEMA *Futex_SemaCreate(INT nInitCount, INT nMaxCount)
+{
+	FUTEXSEMA *pSema;
+	if (nInitCount < 0 || nMaxCount <= 0 || nInitCount > nMaxCount)
+	{
+		return NULL;
+	}
+	pSema = (FUTEXSEMA *)malloc(sizeof(FUTEXSEMA));
+	if (pSema != NULL)
+	{
+		pSema->nCount = nInitCount;
+		pSema->nWaiters = 0;
+		pSema->nMaxCount = nMaxCount;
+	}
+	return pSema;
+}
+
+/*
+ * decrease the count of semaphore, it sleeps while the count is 0
+ * @param FUTEXSEMA *pSema
+ * @return DWORD -- 0 like WAIT_OBJECT_0
+ */
+static inline DWORD Futex_SemaWait(FUTEXSEMA *pSema)
+{
+	INT nCount = __atomic_load_n(&pSema->nCount, __ATOMIC_RELAXED);
+	for (;;)
+	{
+		if (nCount > 0)
+		{
+			if (__atomic_compare_exchange_n(&pSema->nCount, &nCount, nCount - 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			{
+				return 0;
+			}
+			continue;
+		}
+		/*the release reads nWaiters after changing nCount, so one of us sees the other*/
+		(void)__atomic_add_fetch(&pSema->nWaiters, 1, __ATOMIC_SEQ_CST);
+		Futex_Wait(&pSema->nCount, 0);
+		(void)__atomic_sub_fetch(&pSema->nWaiters, 1, __ATOMIC_SEQ_CST);
+		nCount = __atomic_load_n(&pSema->nCount, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * increase the count of semaphore and wake the sleeping threads
+ * @param FUTEXSEMA *pSema
+ * @param INT nReleaseCount
+ * @return BOOL -- FALSE if the count would exceed the max count
+ */
+static inline BOOL Futex_SemaRelease(FUTEXSEMA *pSema, INT nReleaseCount)
+{
+	INT nCount = __atomic_load_n(&pSema->nCount, __ATOMIC_RELAXED);
+	do
+	{
+		if (nReleaseCount <= 0 || nCount > pSema->nMaxCount - nReleaseCount)
+		{
+			return FALSE;
+		}
+	} while (!__atomic_compare_exchange_n(&pSema->nCount, &nCount, nCount + nReleaseCount, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+	if (__atomic_load_n(&pSema->nWaiters, __ATOMIC_SEQ_CST) > 0)
+	{
+		Futex_Wake(&pSema->nCount, nReleaseCount);
+	}
+	return TRUE;
+}
+
+/*
+ * create a thread
+ * @param void *(*ThreadFunc)(void *) -- the thread function
+ * @param void *pArg -- the argument of thread function
+ * @return FUTEXTHREAD * if successfully or return NULL if fail
+ */
+static inline FUTEXTHREAD *Futex_ThreadCreate(void *(*ThreadFunc)(void *), void *pArg)
+{
+	FUTEXTHREAD *pThread = (FUTEXTHREAD *)malloc(sizeof(FUTEXTHREAD));
+	if (pThread != NULL && pthread_create(&pThread->Thread, NULL, ThreadFunc, pArg) != 0)
+	{
+		free(pThread);
+		pThread = NULL;
+	}
+	return pThread;
+}
+
+/*
+ * the linux' signal function used in multi-tasks, the same as windows', the
+ * handles are pointers so that they can be declared together like HANDLE
+ */
+typedef FUTEXLOCK *			LOCK;
+typedef FUTEXEVENT *		EVENT;
+typedef FUTEXSEMA *			SEMAPHORE;
+
+#define LockCreate()		Futex_LockCreate()
+#define Lock(x)				Futex_Lock(x)
+#define Unlock(x)			Futex_Unlock(x)
+#define LockClose(x)		free(x)
+
+#define EventCteate()		Futex_EventCreate()
+#define WaitEvent(x)		Futex_WaitEvent(x)
+#define SendEvent(x)		Futex_SendEvent(x)
+#define EventClose(x)		free(x)
+
+#define SemaCreate(x,y)		Futex_SemaCreate(x,y)
+#define SemaWait(x)			Futex_SemaWait(x)
+#define SemaRelease(x,y)	Futex_SemaRelease(x,y)
+#define SemaClose(x)		free(x)
+
+typedef FUTEXTHREAD *		THREAD;
+#define THREADRET			void *
+#define THREADAPI
+#define ThreadCreate(f,x)	Futex_ThreadCreate((f),(x))
+#define ThreadJoin(x)		(void)pthread_join((x)->Thread, NULL)
+#define ThreadClose(x)		free(x)
+#define ThreadYield()		(void)sched_yield()
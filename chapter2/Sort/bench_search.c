@@ -0,0 +1,330 @@
+/*********************************************************************************
+ * FileName:	bench_search.c
+ * Author:		gehan
+ * Date:		07/12/2017
+ * Description: Benchmark of the lookups in a sorted table of UINT64 keys, it runs
+ *				SortTable_BinarySearch, the search index and the learned index on
+ *				several key distributions with random existing keys, and writes
+ *				the ns per lookup and the extra memory of each index as JSON.
+ *				build:	cc -O2 -I../.. bench_search.c -o bench_search -lm
+ *				usage:	bench_search [-n count] [-q queries] [-r repeat] [-o file.json]
+**********************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include "algo.h"
+#include "binary_search.c"
+#include "searchIndex.c"
+#include "learnedIndex.c"
+
+#define BENCH_COUNT_OF(a)	(sizeof(a) / sizeof((a)[0]))
+
+/*
+ * the key distribution of benchmark, the generated keys are sorted
+ */
+typedef struct BENCHINPUT_st {
+	const char *pszName;
+	void (*GenerateFunc)(UINT64 *puKey, UINT uCount);
+}BENCHINPUT;
+
+/*
+ * the table and the indexes built on it
+ */
+typedef struct BENCHINDEX_st {
+	SORTTABLE *pTable;
+	SEARCHINDEX *pSearch;
+	LEARNEDINDEX *pLearned;
+}BENCHINDEX;
+
+/*
+ * the lookup function of benchmark, it returns the data of key or NULL
+ */
+typedef struct BENCHALGO_st {
+	const char *pszName;
+	void * (*FindFunc)(BENCHINDEX *pIndex, UINT64 *puKey);
+}BENCHALGO;
+
+static UINT64 g_uSeed = 88172645463325252ULL;
+
+static UINT64 Bench_Random(void)
+{
+	g_uSeed ^= g_uSeed << 13;
+	g_uSeed ^= g_uSeed >> 7;
+	g_uSeed ^= g_uSeed << 17;
+	return g_uSeed;
+}
+
+static double Bench_Now(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER Counter, Frequency;
+	QueryPerformanceCounter(&Counter);
+	QueryPerformanceFrequency(&Frequency);
+	return (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (double)Time.tv_sec + (double)Time.tv_nsec * 1e-9;
+#endif
+}
+
+static INT Bench_CompareUInt64(void *pData1, void *pData2)
+{
+	UINT64 u1 = *(UINT64 *)pData1;
+	UINT64 u2 = *(UINT64 *)pData2;
+	return u1 < u2 ? -1 : (u1 > u2 ? 1 : 0);
+}
+
+static int Bench_QsortUInt64(const void *p1, const void *p2)
+{
+	return Bench_CompareUInt64((void *)p1, (void *)p2);
+}
+
+static UINT64 Bench_GetKey(void *pData)
+{
+	return *(UINT64 *)pData;
+}
+
+/*
+ * the generators of key distributions
+ */
+static void Bench_Timestamp(UINT64 *puKey, UINT uCount)
+{
+	/*about one event per millisecond with jitter*/
+	UINT64 uTime = 1500000000000ULL;
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		uTime += 1 + Bench_Random() % 2000;
+		puKey[i] = uTime;
+	}
+}
+
+static void Bench_DenseId(UINT64 *puKey, UINT uCount)
+{
+	/*the ids with a few deleted ones*/
+	UINT64 uId = 1;
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		uId += (0 == Bench_Random() % 16) ? 2 : 1;
+		puKey[i] = uId;
+	}
+}
+
+static void Bench_Uniform(UINT64 *puKey, UINT uCount)
+{
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puKey[i] = Bench_Random() >> 8;
+	}
+	qsort(puKey, uCount, sizeof(UINT64), Bench_QsortUInt64);
+}
+
+static BENCHINPUT g_aInput[] = {
+	{ "timestamp", Bench_Timestamp },
+	{ "dense_id", Bench_DenseId },
+	{ "uniform", Bench_Uniform },
+};
+
+/*
+ * the lookup functions of benchmark
+ */
+static void * Bench_BinarySearch(BENCHINDEX *pIndex, UINT64 *puKey)
+{
+	return SortTable_BinarySearch(pIndex->pTable, puKey, Bench_CompareUInt64);
+}
+
+static void * Bench_SearchIndex(BENCHINDEX *pIndex, UINT64 *puKey)
+{
+	UINT uRank = SearchIndex_LowerBound(pIndex->pSearch, *puKey);
+	if (uRank < pIndex->pTable->uCursorCount && Bench_GetKey(pIndex->pTable->ppData[uRank]) == *puKey)
+	{
+		return pIndex->pTable->ppData[uRank];
+	}
+	return NULL;
+}
+
+static void * Bench_Eytzinger(BENCHINDEX *pIndex, UINT64 *puKey)
+{
+	return SearchIndex_Find(pIndex->pSearch, *puKey);
+}
+
+static void * Bench_LearnedIndex(BENCHINDEX *pIndex, UINT64 *puKey)
+{
+	return LearnedIndex_Find(pIndex->pLearned, *puKey);
+}
+
+static BENCHALGO g_aAlgo[] = {
+	{ "SortTable_BinarySearch", Bench_BinarySearch },
+	{ "SearchIndex_LowerBound", Bench_SearchIndex },
+	{ "SearchIndex_Find", Bench_Eytzinger },
+	{ "LearnedIndex_Find", Bench_LearnedIndex },
+};
+
+/*
+ * run a lookup function with all queries, the best time of repeats is written
+ * @param FILE *pOut
+ * @param INT *pbFirst -- it is 1 before the first result is written
+ * @param BENCHALGO *pAlgo
+ * @param BENCHINPUT *pInput
+ * @param BENCHINDEX *pIndex
+ * @param UINT64 **ppuQuery -- the keys to find, they are all in table
+ * @param UINT uQueryCount
+ * @param UINT uRepeat
+ * @return void
+ */
+static void Bench_Run(FILE *pOut, INT *pbFirst, BENCHALGO *pAlgo, BENCHINPUT *pInput, BENCHINDEX *pIndex,
+	UINT64 **ppuQuery, UINT uQueryCount, UINT uRepeat)
+{
+	double dBest = -1.0;
+	double dStart, dTime;
+	INT bFound = 1;
+	void *pData;
+	UINT i, r;
+
+	for (r = 0; r < uRepeat; ++r)
+	{
+		dStart = Bench_Now();
+		for (i = 0; i < uQueryCount; ++i)
+		{
+			pData = (*pAlgo->FindFunc)(pIndex, ppuQuery[i]);
+			if (NULL == pData || *(UINT64 *)pData != *ppuQuery[i])
+			{
+				bFound = 0;
+			}
+		}
+		dTime = Bench_Now() - dStart;
+		if (dBest < 0 || dTime < dBest)
+		{
+			dBest = dTime;
+		}
+	}
+
+	fprintf(pOut, "%s\n    {\"algorithm\": \"%s\", \"input\": \"%s\", \"ns_per_lookup\": %.3f, ",
+		*pbFirst ? "" : ",", pAlgo->pszName, pInput->pszName, dBest * 1e9 / (double)uQueryCount);
+	*pbFirst = 0;
+	if (Bench_LearnedIndex == pAlgo->FindFunc)
+	{
+		fprintf(pOut, "\"index_bytes\": %u, \"max_error\": %u, ", LearnedIndex_ModelSize(pIndex->pLearned),
+			LearnedIndex_MaxError(pIndex->pLearned));
+	}
+	else if (Bench_BinarySearch != pAlgo->FindFunc)
+	{
+		/*the keys, the tree and its ranks, and the data pointers*/
+		fprintf(pOut, "\"index_bytes\": %.0f, \"max_error\": null, ", (double)sizeof(SEARCHINDEX)
+			+ (double)pIndex->pTable->uCursorCount * (2 * sizeof(UINT64) + sizeof(UINT) + sizeof(void *)));
+	}
+	else
+	{
+		fprintf(pOut, "\"index_bytes\": 0, \"max_error\": null, ");
+	}
+	fprintf(pOut, "\"found\": %s}", bFound ? "true" : "false");
+	fflush(pOut);
+}
+
+int main(int argc, char *argv[])
+{
+	UINT uCount = 10000000;
+	UINT uQueryCount = 1000000;
+	UINT uRepeat = 3;
+	const char *pszOutput = NULL;
+	FILE *pOut = stdout;
+	SORTTABLE Table;
+	BENCHINDEX Index;
+	UINT64 *puKey;
+	UINT64 **ppuQuery;
+	INT bFirst = 1;
+	UINT i, a;
+	INT n;
+
+	for (n = 1; n + 1 < argc; n += 2)
+	{
+		if (0 == strcmp(argv[n], "-n"))
+		{
+			uCount = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-q"))
+		{
+			uQueryCount = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-r"))
+		{
+			uRepeat = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-o"))
+		{
+			pszOutput = argv[n + 1];
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (n < argc || uCount < 2 || uCount > 0x7FFFFFFF || 0 == uQueryCount || 0 == uRepeat)
+	{
+		fprintf(stderr, "usage: %s [-n count] [-q queries] [-r repeat] [-o file.json]\n", argv[0]);
+		return 1;
+	}
+	if (NULL != pszOutput)
+	{
+		pOut = fopen(pszOutput, "w");
+		if (NULL == pOut)
+		{
+			fprintf(stderr, "can't open %s\n", pszOutput);
+			return 1;
+		}
+	}
+
+	puKey = (UINT64 *)malloc((size_t)uCount * sizeof(UINT64));
+	ppuQuery = (UINT64 **)malloc((size_t)uQueryCount * sizeof(UINT64 *));
+	Table.ppData = (void **)malloc((size_t)uCount * sizeof(void *));
+	Table.uMaxCount = uCount;
+	Table.uCursorCount = uCount;
+	SORTSTATS_INIT(&Table);
+	if (NULL == puKey || NULL == ppuQuery || NULL == Table.ppData)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		Table.ppData[i] = &puKey[i];
+	}
+	Index.pTable = &Table;
+
+	fprintf(pOut, "{\n  \"count\": %u,\n  \"queries\": %u,\n  \"repeat\": %u,\n  \"results\": [",
+		uCount, uQueryCount, uRepeat);
+	for (i = 0; i < BENCH_COUNT_OF(g_aInput); ++i)
+	{
+		(*g_aInput[i].GenerateFunc)(puKey, uCount);
+		for (a = 0; a < uQueryCount; ++a)
+		{
+			ppuQuery[a] = &puKey[Bench_Random() % uCount];
+		}
+		Index.pSearch = SearchIndex_Create(&Table, Bench_GetKey);
+		Index.pLearned = LearnedIndex_Create(&Table, Bench_GetKey, 0);
+		if (NULL == Index.pSearch || NULL == Index.pLearned)
+		{
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		for (a = 0; a < BENCH_COUNT_OF(g_aAlgo); ++a)
+		{
+			Bench_Run(pOut, &bFirst, &g_aAlgo[a], &g_aInput[i], &Index, ppuQuery, uQueryCount, uRepeat);
+		}
+		SearchIndex_Destroy(Index.pSearch);
+		LearnedIndex_Destroy(Index.pLearned);
+	}
+	fprintf(pOut, "\n  ]\n}\n");
+
+	if (stdout != pOut)
+	{
+		fclose(pOut);
+	}
+	free(Table.ppData);
+	free(ppuQuery);
+	free(puKey);
+	return 0;
+}
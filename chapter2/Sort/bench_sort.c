@@ -0,0 +1,743 @@
+/*********************************************************************************
+ * FileName:	bench_sort.c
+ * Author:		gehan
+ * Date:		07/11/2017
+ * Description: Benchmark of all sort functions of sort table, it runs each sort on
+ *				several input distributions and element types and writes the
+ *				ns per element and comparison counts as JSON, the small ranges
+ *				of 8 to 64 keys are measured separately in "small_ranges".
+ *				The moves, recursion depth, size-weighted split imbalance and fallbacks are
+ *				reported when it is built with -DSORTTABLE_STATS. The quick sort
+ *				and intro sort are also run with the block split function
+ *				(+BlockSplit), the others use g_bSortTableBlockSplit as it is.
+ *				build:	cc -O2 -I../.. bench_sort.c -o bench_sort (add -pthread on Linux)
+ *				usage:	bench_sort [-n count] [-t int32|int64|double|string|all]
+ *						[-r repeat] [-q quadratic_limit] [-j threads] [-o file.json]
+**********************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include "algo.h"
+#include "quickSort2.c"
+#include "introSort.c"
+#include "stableSort.c"
+#include "parallelSort.c"
+#include "sampleSort.c"
+#include "radixSort.c"
+#include "stringSort.c"
+
+#define BENCH_ZIPF_MAX_DISTINCT	(1 << 20)
+#define BENCH_STRING_SIZE		16
+
+typedef enum BENCHTYPEID_en {
+	BENCH_INT32 = 0,
+	BENCH_INT64,
+	BENCH_DOUBLE,
+	BENCH_STRING,
+	BENCH_TYPE_COUNT
+}BENCHTYPEID;
+
+/*
+ * the element type of benchmark
+ */
+typedef struct BENCHTYPE_st {
+	const char *pszName;
+	BENCHTYPEID Id;
+	COMPAREFUNC CompareFunc;
+	UINT uKeyBytes;			/*the key bytes of radix sort, 0 means it isn't supported*/
+	void (*KernelFunc)(SORTTABLE *pTable, UINT uStart, UINT uEnd);
+}BENCHTYPE;
+
+/*
+ * the input distribution of benchmark, the values are not negative
+ */
+typedef struct BENCHINPUT_st {
+	const char *pszName;
+	void (*GenerateFunc)(UINT32 *puValue, UINT uCount);
+	INT bOrdered;			/*the quick sorts which use the first data as pivot are O(n^2) on it*/
+}BENCHINPUT;
+
+/*
+ * the sort function of benchmark
+ */
+typedef struct BENCHALGO_st {
+	const char *pszName;
+	INT (*SortFunc)(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc);
+	INT bQuadratic;			/*1: O(n^2) on ordered input, 2: O(n^2) on all inputs*/
+	INT bCompare;			/*the comparisons can be counted*/
+}BENCHALGO;
+
+static UINT64 g_uSeed = 88172645463325252ULL;
+static UINT g_uThreadCount = 4;
+static UINT64 g_uCompareCount = 0;
+static COMPAREFUNC g_CountedCompare = NULL;
+
+static UINT64 Bench_Random(void)
+{
+	g_uSeed ^= g_uSeed << 13;
+	g_uSeed ^= g_uSeed >> 7;
+	g_uSeed ^= g_uSeed << 17;
+	return g_uSeed;
+}
+
+static double Bench_Now(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER Counter, Frequency;
+	QueryPerformanceCounter(&Counter);
+	QueryPerformanceFrequency(&Frequency);
+	return (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (double)Time.tv_sec + (double)Time.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+ * the comparison functions of element types
+ */
+static INT Bench_CompareInt32(void *pData1, void *pData2)
+{
+	INT32 n1 = *(INT32 *)pData1, n2 = *(INT32 *)pData2;
+	return (n1 > n2) - (n1 < n2);
+}
+
+static INT Bench_CompareInt64(void *pData1, void *pData2)
+{
+	INT64 n1 = *(INT64 *)pData1, n2 = *(INT64 *)pData2;
+	return (n1 > n2) - (n1 < n2);
+}
+
+static INT Bench_CompareDouble(void *pData1, void *pData2)
+{
+	double d1 = *(double *)pData1, d2 = *(double *)pData2;
+	return (d1 > d2) - (d1 < d2);
+}
+
+static INT Bench_CompareString(void *pData1, void *pData2)
+{
+	return (INT)strcmp((const char *)pData1, (const char *)pData2);
+}
+
+/*the comparison function which counts the calls of g_CountedCompare*/
+static INT Bench_CountCompare(void *pData1, void *pData2)
+{
+	++g_uCompareCount;
+	return (*g_CountedCompare)(pData1, pData2);
+}
+
+/*
+ * the generators of input distributions
+ */
+static void Bench_Random32(UINT32 *puValue, UINT uCount)
+{
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puValue[i] = (UINT32)(Bench_Random() & 0x7FFFFFFF);
+	}
+}
+
+static void Bench_Sorted(UINT32 *puValue, UINT uCount)
+{
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puValue[i] = i;
+	}
+}
+
+static void Bench_Reverse(UINT32 *puValue, UINT uCount)
+{
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puValue[i] = uCount - i;
+	}
+}
+
+static void Bench_Sawtooth(UINT32 *puValue, UINT uCount)
+{
+	UINT uPeriod = uCount / 8 + 1;
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puValue[i] = i % uPeriod;
+	}
+}
+
+static void Bench_OrganPipe(UINT32 *puValue, UINT uCount)
+{
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puValue[i] = (i < uCount / 2) ? i : uCount - i;
+	}
+}
+
+static void Bench_FewUnique(UINT32 *puValue, UINT uCount)
+{
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		puValue[i] = (UINT32)(Bench_Random() % 16);
+	}
+}
+
+/*the rank r is chosen with probability 1 / (r + 1)*/
+static void Bench_Zipf(UINT32 *puValue, UINT uCount)
+{
+	UINT uDistinct = uCount < BENCH_ZIPF_MAX_DISTINCT ? uCount : BENCH_ZIPF_MAX_DISTINCT;
+	double *pdSum = (double *)malloc(uDistinct * sizeof(double));
+	double dSum = 0.0, dRandom;
+	UINT uLow, uHigh, uMid;
+	UINT i;
+	if (NULL == pdSum)
+	{
+		Bench_Random32(puValue, uCount);
+		return;
+	}
+	for (i = 0; i < uDistinct; ++i)
+	{
+		dSum += 1.0 / (double)(i + 1);
+		pdSum[i] = dSum;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		dRandom = (double)(Bench_Random() >> 11) * (1.0 / 9007199254740992.0) * dSum;
+		uLow = 0;
+		uHigh = uDistinct - 1;
+		while (uLow < uHigh)
+		{
+			uMid = (uLow + uHigh) / 2;
+			if (pdSum[uMid] < dRandom)
+			{
+				uLow = uMid + 1;
+			}
+			else
+			{
+				uHigh = uMid;
+			}
+		}
+		puValue[i] = uLow;
+	}
+	free(pdSum);
+}
+
+/*
+ * the sort functions of benchmark, they return CAPI_FAILED if the type isn't supported
+ */
+static INT Bench_QuickSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	SortTable_QuickSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_QuickSort2(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	SortTable_QuickSort2(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_QuickSort3(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	SortTable_QuickSort3(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_IntroSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	SortTable_IntroSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	return CAPI_SUCCESS;
+}
+
+/*the quick sort drivers with SortTable_BlockSplit, so it can be compared with SortTable_Split*/
+static INT Bench_QuickSortBlock(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	INT bBlockSplit = g_bSortTableBlockSplit;
+	(void)pType;
+	g_bSortTableBlockSplit = 1;
+	SortTable_QuickSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	g_bSortTableBlockSplit = bBlockSplit;
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_IntroSortBlock(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	INT bBlockSplit = g_bSortTableBlockSplit;
+	(void)pType;
+	g_bSortTableBlockSplit = 1;
+	SortTable_IntroSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	g_bSortTableBlockSplit = bBlockSplit;
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_HeapSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	SortTable_HeapSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_InsertSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	SortTable_InsertSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_StableSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	return SortTable_StableSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+}
+
+static INT Bench_ParallelSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	return SortTable_ParallelSort(pTable, g_uThreadCount, CompareFunc);
+}
+
+static INT Bench_SampleSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)pType;
+	return SortTable_SampleSort(pTable, g_uThreadCount, CompareFunc);
+}
+
+static INT Bench_KernelSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)CompareFunc;
+	if (NULL == pType->KernelFunc)
+	{
+		return CAPI_FAILED;
+	}
+	(*pType->KernelFunc)(pTable, 0, pTable->uCursorCount - 1);
+	return CAPI_SUCCESS;
+}
+
+static INT Bench_RadixSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)CompareFunc;
+	if (0 == pType->uKeyBytes)
+	{
+		return CAPI_FAILED;
+	}
+	return SortTable_RadixSortUInt(pTable, pType->uKeyBytes);
+}
+
+static INT Bench_StringSort(SORTTABLE *pTable, BENCHTYPE *pType, COMPAREFUNC CompareFunc)
+{
+	(void)CompareFunc;
+	if (BENCH_STRING != pType->Id)
+	{
+		return CAPI_FAILED;
+	}
+	return SortTable_StringSort(pTable, 0, pTable->uCursorCount - 1);
+}
+
+/*the bits of non-negative double have the same order as its value, so radix sort works*/
+static BENCHTYPE g_aType[BENCH_TYPE_COUNT] = {
+	{ "int32", BENCH_INT32, Bench_CompareInt32, 4, SortTable_SortInt32 },
+	{ "int64", BENCH_INT64, Bench_CompareInt64, 8, SortTable_SortInt64 },
+	{ "double", BENCH_DOUBLE, Bench_CompareDouble, 8, SortTable_SortDouble },
+	{ "string", BENCH_STRING, Bench_CompareString, 0, NULL },
+};
+
+static BENCHINPUT g_aInput[] = {
+	{ "random", Bench_Random32, 0 },
+	{ "sorted", Bench_Sorted, 1 },
+	{ "reverse", Bench_Reverse, 1 },
+	{ "sawtooth", Bench_Sawtooth, 1 },
+	{ "organ_pipe", Bench_OrganPipe, 1 },
+	{ "few_unique", Bench_FewUnique, 0 },
+	{ "zipf", Bench_Zipf, 0 },
+};
+
+static BENCHALGO g_aAlgo[] = {
+	{ "SortTable_QuickSort", Bench_QuickSort, 1, 1 },
+	{ "SortTable_QuickSort2", Bench_QuickSort2, 1, 1 },
+	{ "SortTable_QuickSort3", Bench_QuickSort3, 1, 1 },
+	{ "SortTable_IntroSort", Bench_IntroSort, 0, 1 },
+	{ "SortTable_QuickSort+BlockSplit", Bench_QuickSortBlock, 1, 1 },
+	{ "SortTable_IntroSort+BlockSplit", Bench_IntroSortBlock, 0, 1 },
+	{ "SortTable_HeapSort", Bench_HeapSort, 0, 1 },
+	{ "SortTable_InsertSort", Bench_InsertSort, 2, 1 },
+	{ "SortTable_StableSort", Bench_StableSort, 0, 1 },
+	{ "SortTable_ParallelSort", Bench_ParallelSort, 0, 0 },
+	{ "SortTable_SampleSort", Bench_SampleSort, 0, 0 },
+	{ "SortTable_Sort<Type>", Bench_KernelSort, 0, 0 },
+	{ "SortTable_RadixSortUInt", Bench_RadixSort, 0, 0 },
+	{ "SortTable_StringSort", Bench_StringSort, 0, 0 },
+};
+
+#define BENCH_COUNT_OF(a)	(sizeof(a) / sizeof((a)[0]))
+
+/*
+ * the sort functions of small ranges, the table is sorted range by range and
+ * pnKey is the INT32 array which ppData points to
+ */
+typedef struct BENCHSMALL_st {
+	const char *pszName;
+	void (*SortFunc)(SORTTABLE *pTable, INT32 *pnKey, UINT uStart, UINT uCount);
+}BENCHSMALL;
+
+/*the insertion sorts which the sorting network replaces in SortPtr_Int32 and Sort_Int32*/
+SORTKERNEL_DEFINE_INSERTSORT(SortPtr_Int32, void *, SORTKERNEL_LESS_INT32)
+SORTKERNEL_DEFINE_INSERTSORT(Sort_Int32, INT32, SORTKERNEL_LESS)
+
+static void Bench_SmallInsertSort(SORTTABLE *pTable, INT32 *pnKey, UINT uStart, UINT uCount)
+{
+	(void)pnKey;
+	SortTable_InsertSort(pTable, uStart, uStart + uCount - 1, Bench_CompareInt32);
+}
+
+static void Bench_SmallKernelInsertSort(SORTTABLE *pTable, INT32 *pnKey, UINT uStart, UINT uCount)
+{
+	(void)pnKey;
+	SortPtr_Int32_InsertSort(pTable->ppData + uStart, uCount);
+}
+
+static void Bench_SmallNetPtr(SORTTABLE *pTable, INT32 *pnKey, UINT uStart, UINT uCount)
+{
+	(void)pnKey;
+	(void)SortNet_PtrInt32(pTable->ppData + uStart, uCount);
+}
+
+static void Bench_SmallKernelArray(SORTTABLE *pTable, INT32 *pnKey, UINT uStart, UINT uCount)
+{
+	(void)pTable;
+	Sort_Int32_InsertSort(pnKey + uStart, uCount);
+}
+
+static void Bench_SmallNetArray(SORTTABLE *pTable, INT32 *pnKey, UINT uStart, UINT uCount)
+{
+	(void)pTable;
+	(void)SortNet_Int32(pnKey + uStart, uCount);
+}
+
+static BENCHSMALL g_aSmall[] = {
+	{ "SortTable_InsertSort", Bench_SmallInsertSort },
+	{ "SortPtr_Int32_InsertSort", Bench_SmallKernelInsertSort },
+	{ "SortNet_PtrInt32", Bench_SmallNetPtr },
+	{ "Sort_Int32_InsertSort", Bench_SmallKernelArray },
+	{ "SortNet_Int32", Bench_SmallNetArray },
+};
+
+static const UINT g_auSmallSize[] = { 8, 16, 32, 64 };
+
+/*
+ * create the data of element type from the values, the data pointers are saved into ppData
+ * @param BENCHTYPE *pType
+ * @param const UINT32 *puValue
+ * @param UINT uCount
+ * @param void **ppData
+ * @return void * -- the buffer of data, return NULL if failed
+ */
+static void * Bench_CreateData(BENCHTYPE *pType, const UINT32 *puValue, UINT uCount, void **ppData)
+{
+	static const size_t auSize[BENCH_TYPE_COUNT] = { sizeof(INT32), sizeof(INT64), sizeof(double),
+		BENCH_STRING_SIZE };
+	char *pBuffer = (char *)malloc((size_t)uCount * auSize[pType->Id]);
+	UINT i;
+	if (NULL == pBuffer)
+	{
+		return NULL;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		ppData[i] = pBuffer + (size_t)i * auSize[pType->Id];
+		switch (pType->Id)
+		{
+		case BENCH_INT32:
+			*(INT32 *)ppData[i] = (INT32)puValue[i];
+			break;
+		case BENCH_INT64:
+			*(INT64 *)ppData[i] = (INT64)puValue[i] * 1000003;
+			break;
+		case BENCH_DOUBLE:
+			*(double *)ppData[i] = (double)puValue[i] * 0.5 + 0.25;
+			break;
+		default:
+			/*the zero padded number has the same order as the value*/
+			sprintf((char *)ppData[i], "key%010u", (unsigned)puValue[i]);
+			break;
+		}
+	}
+	return pBuffer;
+}
+
+/*
+ * check the sort table is sorted
+ * @param SORTTABLE *pTable
+ * @param COMPAREFUNC CompareFunc
+ * @return INT -- 1 if it is sorted
+ */
+static INT Bench_IsSorted(SORTTABLE *pTable, COMPAREFUNC CompareFunc)
+{
+	UINT i;
+	for (i = 1; i < pTable->uCursorCount; ++i)
+	{
+		if ((*CompareFunc)(pTable->ppData[i - 1], pTable->ppData[i]) > 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * run a sort function on an input and write one JSON object
+ * @return void
+ */
+static void Bench_Run(FILE *pOut, INT *pbFirst, BENCHALGO *pAlgo, BENCHTYPE *pType, BENCHINPUT *pInput,
+	void **ppData, SORTTABLE *pTable, UINT uRepeat, UINT uQuadraticLimit)
+{
+	double dBest = -1.0, dStart, dTime;
+	const char *pszSkip = NULL;
+	INT bSorted = 1;
+	UINT uCount = pTable->uMaxCount;
+	UINT i;
+
+	if ((2 == pAlgo->bQuadratic || (1 == pAlgo->bQuadratic && pInput->bOrdered))
+		&& uCount > uQuadraticLimit)
+	{
+		pszSkip = "quadratic";
+	}
+	for (i = 0; NULL == pszSkip && i < uRepeat; ++i)
+	{
+		memcpy(pTable->ppData, ppData, uCount * sizeof(void *));
+		pTable->uCursorCount = uCount;
+		dStart = Bench_Now();
+		if (CAPI_SUCCESS != (*pAlgo->SortFunc)(pTable, pType, pType->CompareFunc))
+		{
+			pszSkip = "unsupported";
+			break;
+		}
+		dTime = Bench_Now() - dStart;
+		if (dBest < 0 || dTime < dBest)
+		{
+			dBest = dTime;
+		}
+		bSorted = bSorted && Bench_IsSorted(pTable, pType->CompareFunc);
+	}
+
+	fprintf(pOut, "%s\n    {\"algorithm\": \"%s\", \"type\": \"%s\", \"input\": \"%s\", ",
+		*pbFirst ? "" : ",", pAlgo->pszName, pType->pszName, pInput->pszName);
+	*pbFirst = 0;
+	if (NULL != pszSkip)
+	{
+		fprintf(pOut, "\"skipped\": \"%s\"}", pszSkip);
+		return;
+	}
+	fprintf(pOut, "\"ns_per_element\": %.3f, ", dBest * 1e9 / (double)uCount);
+
+	/*count the comparisons in a separate run so the timing isn't affected*/
+	if (pAlgo->bCompare)
+	{
+#if defined(SORTTABLE_STATS)
+		SORTSTATS Stats;
+		SortStats_Reset(&Stats);
+		pTable->pStats = &Stats;
+#endif
+		memcpy(pTable->ppData, ppData, uCount * sizeof(void *));
+		pTable->uCursorCount = uCount;
+		g_uCompareCount = 0;
+		g_CountedCompare = pType->CompareFunc;
+		(void)(*pAlgo->SortFunc)(pTable, pType, Bench_CountCompare);
+		fprintf(pOut, "\"comparisons\": %llu, ", (unsigned long long)g_uCompareCount);
+#if defined(SORTTABLE_STATS)
+		pTable->pStats = NULL;
+		fprintf(pOut, "\"moves\": %llu, \"max_depth\": %u, \"imbalance\": %.3f, \"fallbacks\": %u, ",
+			(unsigned long long)Stats.uMoveCount, Stats.uMaxDepth, SortStats_Imbalance(&Stats), Stats.uFallbackCount);
+#else
+		fprintf(pOut, "\"moves\": null, \"max_depth\": null, \"imbalance\": null, \"fallbacks\": null, ");
+#endif
+	}
+	else
+	{
+		/*the sort functions of primitive keys aren't instrumented*/
+		fprintf(pOut, "\"comparisons\": null, \"moves\": null, \"max_depth\": null, "
+			"\"imbalance\": null, \"fallbacks\": null, ");
+	}
+	fprintf(pOut, "\"sorted\": %s}", bSorted ? "true" : "false");
+	fflush(pOut);
+}
+
+/*
+ * run the sort functions of small ranges on random int32 values, the table is
+ * split into ranges of each size and all ranges are sorted in a run
+ * @return void
+ */
+static void Bench_RunSmall(FILE *pOut, UINT32 *puValue, void **ppData, SORTTABLE *pTable, UINT uRepeat)
+{
+	INT32 *pnKey = (INT32 *)malloc(pTable->uMaxCount * sizeof(INT32));
+	void *pBuffer;
+	double dBest, dStart, dTime;
+	INT bFirst = 1;
+	UINT uSize, uCount;
+	UINT a, s, i, r;
+
+	Bench_Random32(puValue, pTable->uMaxCount);
+	pBuffer = Bench_CreateData(&g_aType[BENCH_INT32], puValue, pTable->uMaxCount, ppData);
+	if (NULL == pnKey || NULL == pBuffer)
+	{
+		free(pnKey);
+		free(pBuffer);
+		return;
+	}
+	for (s = 0; s < BENCH_COUNT_OF(g_auSmallSize); ++s)
+	{
+		uSize = g_auSmallSize[s];
+		uCount = pTable->uMaxCount / uSize * uSize;
+		if (0 == uCount)
+		{
+			continue;
+		}
+		for (a = 0; a < BENCH_COUNT_OF(g_aSmall); ++a)
+		{
+			dBest = -1.0;
+			for (r = 0; r < uRepeat; ++r)
+			{
+				memcpy(pTable->ppData, ppData, uCount * sizeof(void *));
+				memcpy(pnKey, pBuffer, uCount * sizeof(INT32));
+				pTable->uCursorCount = uCount;
+				dStart = Bench_Now();
+				for (i = 0; i < uCount; i += uSize)
+				{
+					(*g_aSmall[a].SortFunc)(pTable, pnKey, i, uSize);
+				}
+				dTime = Bench_Now() - dStart;
+				if (dBest < 0 || dTime < dBest)
+				{
+					dBest = dTime;
+				}
+			}
+			fprintf(pOut, "%s\n    {\"algorithm\": \"%s\", \"type\": \"int32\", \"size\": %u, "
+				"\"ns_per_element\": %.3f}", bFirst ? "" : ",", g_aSmall[a].pszName, uSize,
+				dBest * 1e9 / (double)uCount);
+			bFirst = 0;
+		}
+	}
+	fflush(pOut);
+	free(pBuffer);
+	free(pnKey);
+}
+
+int main(int argc, char *argv[])
+{
+	UINT uCount = 1000000;
+	UINT uRepeat = 3;
+	UINT uQuadraticLimit = 10000;
+	const char *pszType = "all";
+	const char *pszOutput = NULL;
+	FILE *pOut = stdout;
+	SORTTABLE Table;
+	UINT32 *puValue;
+	void **ppData;
+	void *pBuffer;
+	INT bFirst = 1;
+	UINT t, i, a;
+	INT n;
+
+	for (n = 1; n + 1 < argc; n += 2)
+	{
+		if (0 == strcmp(argv[n], "-n"))
+		{
+			uCount = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-t"))
+		{
+			pszType = argv[n + 1];
+		}
+		else if (0 == strcmp(argv[n], "-r"))
+		{
+			uRepeat = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-q"))
+		{
+			uQuadraticLimit = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-j"))
+		{
+			g_uThreadCount = (UINT)strtoul(argv[n + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[n], "-o"))
+		{
+			pszOutput = argv[n + 1];
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (n < argc || uCount < 2 || 0 == uRepeat)
+	{
+		fprintf(stderr, "usage: %s [-n count] [-t int32|int64|double|string|all] [-r repeat]"
+			" [-q quadratic_limit] [-j threads] [-o file.json]\n", argv[0]);
+		return 1;
+	}
+	if (NULL != pszOutput)
+	{
+		pOut = fopen(pszOutput, "w");
+		if (NULL == pOut)
+		{
+			fprintf(stderr, "can't open %s\n", pszOutput);
+			return 1;
+		}
+	}
+
+	puValue = (UINT32 *)malloc(uCount * sizeof(UINT32));
+	ppData = (void **)malloc(uCount * sizeof(void *));
+	Table.ppData = (void **)malloc(uCount * sizeof(void *));
+	Table.uMaxCount = uCount;
+	Table.uCursorCount = 0;
+	SORTSTATS_INIT(&Table);
+	if (NULL == puValue || NULL == ppData || NULL == Table.ppData)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	fprintf(pOut, "{\n  \"count\": %u,\n  \"repeat\": %u,\n  \"threads\": %u,\n  \"results\": [",
+		uCount, uRepeat, g_uThreadCount);
+	for (t = 0; t < BENCH_TYPE_COUNT; ++t)
+	{
+		if (0 != strcmp(pszType, "all") && 0 != strcmp(pszType, g_aType[t].pszName))
+		{
+			continue;
+		}
+		for (i = 0; i < BENCH_COUNT_OF(g_aInput); ++i)
+		{
+			(*g_aInput[i].GenerateFunc)(puValue, uCount);
+			pBuffer = Bench_CreateData(&g_aType[t], puValue, uCount, ppData);
+			if (NULL == pBuffer)
+			{
+				fprintf(stderr, "out of memory\n");
+				return 1;
+			}
+			for (a = 0; a < BENCH_COUNT_OF(g_aAlgo); ++a)
+			{
+				Bench_Run(pOut, &bFirst, &g_aAlgo[a], &g_aType[t], &g_aInput[i], ppData, &Table,
+					uRepeat, uQuadraticLimit);
+			}
+			free(pBuffer);
+		}
+	}
+	fprintf(pOut, "\n  ],\n  \"small_ranges\": [");
+	Bench_RunSmall(pOut, puValue, ppData, &Table, uRepeat);
+	fprintf(pOut, "\n  ]\n}\n");
+
+	if (stdout != pOut)
+	{
+		fclose(pOut);
+	}
+	free(Table.ppData);
+	free(ppData);
+	free(puValue);
+	return 0;
+}
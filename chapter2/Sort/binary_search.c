@@ -5,13 +5,9 @@
  * Description: Binary search in a sorted table
 **********************************************************************************/
 
+#pragma once
 #include "algo.h"
-
-typedef struct SORTTABLE_st {
-	void **ppData;		/*the pointer array that storage data pointer*/
-	UINT uCursorCount;
-	UINT uMaxCount;
-}SORTTABLE;
+#include "quickSort.c"
 
 /*
  * Binary search for sort table
@@ -0,0 +1,114 @@
+/*********************************************************************************
+ * FileName:	cpu.c
+ * Author:		gehan
+ * Date:		07/11/2017
+ * Description: Detect the SIMD instruction sets of CPU at runtime, the functions
+ *				which use them are compiled with target attribute so that the
+ *				whole file doesn't need -mavx2
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86
+#endif
+
+#if defined(CPU_X86)
+#if defined(_MSC_VER)
+#define CPU_TARGET_SSE2
+#define CPU_TARGET_SSE41
+#define CPU_TARGET_SSE42
+#define CPU_TARGET_AVX2
+#else
+#include <immintrin.h>
+#define CPU_TARGET_SSE2		__attribute__((target("sse2")))
+#define CPU_TARGET_SSE41	__attribute__((target("sse4.1")))
+#define CPU_TARGET_SSE42	__attribute__((target("sse4.2")))
+#define CPU_TARGET_AVX2		__attribute__((target("avx2")))
+#endif
+#endif
+
+#define CPU_FEATURE_SSE2	0x01
+#define CPU_FEATURE_SSE41	0x02
+#define CPU_FEATURE_SSE42	0x04
+#define CPU_FEATURE_AVX2	0x08
+
+/*
+ * get the SIMD instruction sets supported by both CPU and OS
+ * @return UINT -- the bits of CPU_FEATURE_*
+ */
+UINT Cpu_GetFeatures(void)
+{
+	static volatile LONG lFeatures = -1;
+	UINT uFeatures = 0;
+	if (lFeatures >= 0)
+	{
+		return (UINT)lFeatures;
+	}
+#if defined(CPU_X86) && defined(_MSC_VER)
+	{
+		int anInfo[4];
+		__cpuid(anInfo, 0);
+		if (anInfo[0] >= 1)
+		{
+			__cpuid(anInfo, 1);
+			uFeatures |= (anInfo[3] & (1 << 26)) ? CPU_FEATURE_SSE2 : 0;
+			uFeatures |= (anInfo[2] & (1 << 19)) ? CPU_FEATURE_SSE41 : 0;
+			uFeatures |= (anInfo[2] & (1 << 20)) ? CPU_FEATURE_SSE42 : 0;
+			/*the OS must save the YMM registers when switching thread*/
+			if ((anInfo[2] & (1 << 27)) && 6 == (_xgetbv(0) & 6))
+			{
+				__cpuidex(anInfo, 7, 0);
+				uFeatures |= (anInfo[1] & (1 << 5)) ? CPU_FEATURE_AVX2 : 0;
+			}
+		}
+	}
+#elif defined(CPU_X86)
+	__builtin_cpu_init();
+	uFeatures |= __builtin_cpu_supports("sse2") ? CPU_FEATURE_SSE2 : 0;
+	uFeatures |= __builtin_cpu_supports("sse4.1") ? CPU_FEATURE_SSE41 : 0;
+	uFeatures |= __builtin_cpu_supports("sse4.2") ? CPU_FEATURE_SSE42 : 0;
+	uFeatures |= __builtin_cpu_supports("avx2") ? CPU_FEATURE_AVX2 : 0;
+#endif
+	lFeatures = (LONG)uFeatures;
+	return uFeatures;
+}
+
+/*
+ * get the count of logical processors
+ * @return UINT -- it is at least 1
+ */
+UINT Cpu_GetCount(void)
+{
+#if defined(_WIN32)
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	return Info.dwNumberOfProcessors > 0 ? (UINT)Info.dwNumberOfProcessors : 1;
+#else
+	long lCount = sysconf(_SC_NPROCESSORS_ONLN);
+	return lCount > 0 ? (UINT)lCount : 1;
+#endif
+}
+
+/*
+ * count the trailing zero bits of a nonzero value
+ * @param UINT uValue
+ * @return UINT
+ */
+UINT Cpu_TrailingZero(UINT uValue)
+{
+#if defined(_MSC_VER)
+	unsigned long uIndex;
+	_BitScanForward(&uIndex, uValue);
+	return (UINT)uIndex;
+#else
+	return (UINT)__builtin_ctz(uValue);
+#endif
+}
@@ -0,0 +1,598 @@
+/*********************************************************************************
+ * FileName:	externalSort.c
+ * Author:		gehan
+ * Date:		07/10/2017
+ * Description: External merge sort for record file larger than memory, the file is
+ *				sorted chunk by chunk into temporary runs, and the runs are merged by
+ *				a loser tree with large buffered sequential I/O
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "stableSort.c"
+
+/*
+ * the configuration of external sort
+ */
+typedef struct EXTSORTCONFIG_st {
+	UINT uRecordSize;		/*the size of fixed-size record, 0 means each record has a UINT32 length prefix*/
+	UINT uMemorySize;		/*the memory for sorting a chunk in bytes*/
+	UINT uFanIn;			/*the max count of runs merged at one time*/
+	UINT uBufferSize;		/*the I/O buffer size of each file in bytes*/
+}EXTSORTCONFIG;
+
+/*
+ * the file with its own I/O buffer
+ */
+typedef struct EXTFILE_st {
+	FILE *pFile;
+	char *pBuffer;
+}EXTFILE;
+
+/*
+ * the reader of a sorted run
+ */
+typedef struct EXTRUN_st {
+	FILE *pFile;
+	unsigned char *pRecord;	/*the current record, it is NULL if the run is exhausted*/
+	UINT uRecordMax;		/*the allocated size of pRecord*/
+}EXTRUN;
+
+/*
+ * the shared data of external sort
+ */
+typedef struct EXTSORT_st {
+	EXTSORTCONFIG Config;
+	COMPAREFUNC CompareFunc;
+	EXTFILE *pRunFile;		/*the temporary files of runs*/
+	UINT uRunCount;
+	UINT uRunMax;
+}EXTSORT;
+
+/*
+ * read some bytes from file, the end of file is an error if some bytes are read
+ * @param FILE *pFile
+ * @param void *pBuffer
+ * @param UINT uSize
+ * @return INT -- return 1 if read all bytes, 0 if end of file before any byte, CAPI_FAILED if error
+ */
+static INT ExtSort_ReadBytes(FILE *pFile, void *pBuffer, UINT uSize)
+{
+	size_t uRead = fread(pBuffer, 1, uSize, pFile);
+	if (uRead == uSize)
+	{
+		return 1;
+	}
+	/*a truncated record is an error, it can't be dropped silently*/
+	return (0 == uRead && feof(pFile)) ? 0 : CAPI_FAILED;
+}
+
+/*
+ * read a record from file, the length-prefixed record keeps its prefix
+ * @param FILE *pFile
+ * @param UINT uRecordSize -- 0 means the record is length-prefixed
+ * @param unsigned char **ppRecord -- the buffer, it will be enlarged if necessary
+ * @param UINT *puRecordMax -- the size of buffer
+ * @return INT -- return 1 if read a record, 0 if end of file, CAPI_FAILED if error or truncated
+ */
+static INT ExtSort_ReadRecord(FILE *pFile, UINT uRecordSize, unsigned char **ppRecord, UINT *puRecordMax)
+{
+	UINT32 uLen;
+	UINT uSize;
+	INT nRead;
+	if (0 == uRecordSize)
+	{
+		nRead = ExtSort_ReadBytes(pFile, &uLen, (UINT)sizeof(UINT32));
+		if (1 != nRead)
+		{
+			return nRead;
+		}
+		/*the size with prefix must fit in UINT*/
+		if (uLen > (UINT)-1 - (UINT)sizeof(UINT32))
+		{
+			return CAPI_FAILED;
+		}
+		uSize = (UINT)sizeof(UINT32) + uLen;
+	}
+	else
+	{
+		uSize = uRecordSize;
+	}
+	if (uSize > *puRecordMax)
+	{
+		unsigned char *pRecord = (unsigned char *)realloc(*ppRecord, uSize);
+		if (NULL == pRecord)
+		{
+			return CAPI_FAILED;
+		}
+		*ppRecord = pRecord;
+		*puRecordMax = uSize;
+	}
+	if (0 == uRecordSize)
+	{
+		memcpy(*ppRecord, &uLen, sizeof(UINT32));
+		if (uLen > 0 && 1 != ExtSort_ReadBytes(pFile, *ppRecord + sizeof(UINT32), uLen))
+		{
+			return CAPI_FAILED;
+		}
+		return 1;
+	}
+	return ExtSort_ReadBytes(pFile, *ppRecord, uSize);
+}
+
+/*
+ * get the size of record in memory
+ * @param unsigned char *pRecord
+ * @param UINT uRecordSize -- 0 means the record is length-prefixed
+ * @return UINT
+ */
+static UINT ExtSort_RecordSize(unsigned char *pRecord, UINT uRecordSize)
+{
+	UINT32 uLen;
+	if (0 != uRecordSize)
+	{
+		return uRecordSize;
+	}
+	memcpy(&uLen, pRecord, sizeof(UINT32));
+	return (UINT)sizeof(UINT32) + uLen;
+}
+
+/*
+ * open a file with large I/O buffer
+ * @param EXTSORT *pSort
+ * @param const char *pszName -- the file name, open a temporary file if it is NULL
+ * @param const char *pszMode
+ * @param EXTFILE *pFile -- receive the opened file
+ * @return INT
+ */
+static INT ExtSort_OpenFile(EXTSORT *pSort, const char *pszName, const char *pszMode, EXTFILE *pFile)
+{
+	pFile->pFile = (NULL == pszName) ? tmpfile() : fopen(pszName, pszMode);
+	if (NULL == pFile->pFile)
+	{
+		return CAPI_FAILED;
+	}
+	/*the buffer must be set before any I/O, use the default one if no memory*/
+	pFile->pBuffer = (char *)malloc(pSort->Config.uBufferSize);
+	if (NULL != pFile->pBuffer)
+	{
+		(void)setvbuf(pFile->pFile, pFile->pBuffer, _IOFBF, pSort->Config.uBufferSize);
+	}
+	return CAPI_SUCCESS;
+}
+
+/*
+ * close the file and free its I/O buffer
+ * @param EXTFILE *pFile
+ * @return INT
+ */
+static INT ExtSort_CloseFile(EXTFILE *pFile)
+{
+	INT nRet = (0 == fclose(pFile->pFile)) ? CAPI_SUCCESS : CAPI_FAILED;
+	free(pFile->pBuffer);
+	return nRet;
+}
+
+/*
+ * add a run file into the run list
+ * @param EXTSORT *pSort
+ * @param EXTFILE *pFile
+ * @return INT
+ */
+static INT ExtSort_AddRun(EXTSORT *pSort, EXTFILE *pFile)
+{
+	if (pSort->uRunCount == pSort->uRunMax)
+	{
+		EXTFILE *pRunFile = (EXTFILE *)realloc(pSort->pRunFile, pSort->uRunMax * 2 * sizeof(EXTFILE));
+		if (NULL == pRunFile)
+		{
+			return CAPI_FAILED;
+		}
+		pSort->pRunFile = pRunFile;
+		pSort->uRunMax *= 2;
+	}
+	pSort->pRunFile[pSort->uRunCount] = *pFile;
+	++pSort->uRunCount;
+	return CAPI_SUCCESS;
+}
+
+/*
+ * read the input file chunk by chunk, sort each chunk in memory and
+ * spill it into a temporary run file
+ * @param EXTSORT *pSort
+ * @param FILE *pInput
+ * @return INT
+ */
+static INT ExtSort_CreateRuns(EXTSORT *pSort, FILE *pInput)
+{
+	UINT uRecordSize = pSort->Config.uRecordSize;
+	unsigned char *pChunk;
+	unsigned char *pRecord = NULL;
+	UINT uRecordMax = 0;
+	UINT uChunkSize, uUsed, uSize, i;
+	SORTTABLE Table;
+	EXTFILE Run;
+	INT bPending = 0;		/*whether pRecord is read but not put into chunk*/
+	INT nRead = 1;
+	INT nRet = CAPI_SUCCESS;
+
+	/*the chunk keeps records and the pointer table shares the same memory budget*/
+	Table.uMaxCount = pSort->Config.uMemorySize / (4 * sizeof(void *));
+	uChunkSize = pSort->Config.uMemorySize - Table.uMaxCount * sizeof(void *);
+	pChunk = (unsigned char *)malloc(uChunkSize);
+	Table.ppData = (void **)malloc(Table.uMaxCount * sizeof(void *));
+	SORTSTATS_INIT(&Table);
+	if (NULL == pChunk || NULL == Table.ppData)
+	{
+		free(pChunk);
+		free(Table.ppData);
+		return CAPI_FAILED;
+	}
+	while (CAPI_SUCCESS == nRet)
+	{
+		uUsed = 0;
+		Table.uCursorCount = 0;
+		/*fill the chunk until the memory or table is full*/
+		for (;;)
+		{
+			if (!bPending)
+			{
+				nRead = ExtSort_ReadRecord(pInput, uRecordSize, &pRecord, &uRecordMax);
+				if (nRead <= 0)
+				{
+					break;
+				}
+			}
+			bPending = 0;
+			uSize = ExtSort_RecordSize(pRecord, uRecordSize);
+			if (uSize > uChunkSize)
+			{
+				nRead = CAPI_FAILED;
+				break;
+			}
+			if (uUsed + uSize > uChunkSize || Table.uCursorCount == Table.uMaxCount)
+			{
+				/*keep the record for the next chunk*/
+				bPending = 1;
+				break;
+			}
+			memcpy(pChunk + uUsed, pRecord, uSize);
+			Table.ppData[Table.uCursorCount] = pChunk + uUsed;
+			++Table.uCursorCount;
+			uUsed += uSize;
+		}
+		if (nRead < 0)
+		{
+			nRet = CAPI_FAILED;
+			break;
+		}
+		if (0 == Table.uCursorCount)
+		{
+			break;
+		}
+
+		/*the stable sort keeps equal records in input order*/
+		if (CAPI_SUCCESS != SortTable_StableSort(&Table, 0, Table.uCursorCount - 1, pSort->CompareFunc))
+		{
+			nRet = CAPI_FAILED;
+			break;
+		}
+		if (CAPI_SUCCESS != ExtSort_OpenFile(pSort, NULL, NULL, &Run))
+		{
+			nRet = CAPI_FAILED;
+			break;
+		}
+		for (i = 0; i < Table.uCursorCount; ++i)
+		{
+			uSize = ExtSort_RecordSize((unsigned char *)Table.ppData[i], uRecordSize);
+			if (1 != fwrite(Table.ppData[i], uSize, 1, Run.pFile))
+			{
+				nRet = CAPI_FAILED;
+				break;
+			}
+		}
+		if (CAPI_SUCCESS != nRet || 0 != fflush(Run.pFile) || CAPI_SUCCESS != ExtSort_AddRun(pSort, &Run))
+		{
+			(void)ExtSort_CloseFile(&Run);
+			nRet = CAPI_FAILED;
+		}
+		if (!bPending)
+		{
+			break;
+		}
+	}
+	free(pRecord);
+	free(pChunk);
+	free(Table.ppData);
+	return nRet;
+}
+
+/*
+ * compare the current records of two runs, the exhausted run is the greatest
+ * and the run with smaller index wins the tie so that the merge is stable
+ * @param EXTSORT *pSort
+ * @param EXTRUN *pRun
+ * @param UINT uA
+ * @param UINT uB
+ * @return INT -- return nonzero if run uA wins
+ */
+static INT ExtSort_RunLess(EXTSORT *pSort, EXTRUN *pRun, UINT uA, UINT uB)
+{
+	INT nResult;
+	if (NULL == pRun[uA].pRecord)
+	{
+		return 0;
+	}
+	if (NULL == pRun[uB].pRecord)
+	{
+		return 1;
+	}
+	nResult = (*pSort->CompareFunc)(pRun[uA].pRecord, pRun[uB].pRecord);
+	return nResult < 0 || (0 == nResult && uA < uB);
+}
+
+/*
+ * advance a run to its next record
+ * @param EXTSORT *pSort
+ * @param EXTRUN *pRun
+ * @return INT
+ */
+static INT ExtSort_RunNext(EXTSORT *pSort, EXTRUN *pRun)
+{
+	INT nRead = ExtSort_ReadRecord(pRun->pFile, pSort->Config.uRecordSize, &pRun->pRecord, &pRun->uRecordMax);
+	if (nRead < 0)
+	{
+		return CAPI_FAILED;
+	}
+	if (0 == nRead)
+	{
+		free(pRun->pRecord);
+		pRun->pRecord = NULL;
+		pRun->uRecordMax = 0;
+	}
+	return CAPI_SUCCESS;
+}
+
+/*
+ * merge the runs [uFirst, uFirst + uCount) into pOutput by a loser tree
+ * @param EXTSORT *pSort
+ * @param UINT uFirst
+ * @param UINT uCount
+ * @param FILE *pOutput
+ * @return INT
+ */
+static INT ExtSort_MergeRuns(EXTSORT *pSort, UINT uFirst, UINT uCount, FILE *pOutput)
+{
+	EXTRUN *pRun;
+	UINT *puTree;		/*puTree[0] is the winner, puTree[1..uCount) are the losers*/
+	UINT uWinner, uNode, uTemp, i;
+	INT nRet = CAPI_SUCCESS;
+
+	pRun = (EXTRUN *)calloc(uCount, sizeof(EXTRUN));
+	puTree = (UINT *)malloc(uCount * sizeof(UINT));
+	if (NULL == pRun || NULL == puTree)
+	{
+		for (i = 0; i < uCount; ++i)
+		{
+			(void)ExtSort_CloseFile(&pSort->pRunFile[uFirst + i]);
+		}
+		free(pRun);
+		free(puTree);
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount && CAPI_SUCCESS == nRet; ++i)
+	{
+		pRun[i].pFile = pSort->pRunFile[uFirst + i].pFile;
+		rewind(pRun[i].pFile);
+		nRet = ExtSort_RunNext(pSort, &pRun[i]);
+	}
+
+	if (CAPI_SUCCESS == nRet)
+	{
+		/*build the loser tree, the leaf of run i is node uCount + i*/
+		for (i = 0; i < uCount; ++i)
+		{
+			puTree[i] = uCount;
+		}
+		for (i = 0; i < uCount; ++i)
+		{
+			uWinner = i;
+			for (uNode = (uCount + i) / 2; uNode > 0; uNode /= 2)
+			{
+				if (uCount == puTree[uNode])
+				{
+					/*the node is empty, the winner stops here*/
+					puTree[uNode] = uWinner;
+					uWinner = uCount;
+					break;
+				}
+				if (ExtSort_RunLess(pSort, pRun, puTree[uNode], uWinner))
+				{
+					uTemp = puTree[uNode];
+					puTree[uNode] = uWinner;
+					uWinner = uTemp;
+				}
+			}
+			if (uCount != uWinner)
+			{
+				puTree[0] = uWinner;
+			}
+		}
+
+		/*output the winner and replay its path to root*/
+		while (NULL != pRun[puTree[0]].pRecord)
+		{
+			uWinner = puTree[0];
+			if (1 != fwrite(pRun[uWinner].pRecord,
+				ExtSort_RecordSize(pRun[uWinner].pRecord, pSort->Config.uRecordSize), 1, pOutput)
+				|| CAPI_SUCCESS != ExtSort_RunNext(pSort, &pRun[uWinner]))
+			{
+				nRet = CAPI_FAILED;
+				break;
+			}
+			for (uNode = (uCount + uWinner) / 2; uNode > 0; uNode /= 2)
+			{
+				if (ExtSort_RunLess(pSort, pRun, puTree[uNode], uWinner))
+				{
+					uTemp = puTree[uNode];
+					puTree[uNode] = uWinner;
+					uWinner = uTemp;
+				}
+			}
+			puTree[0] = uWinner;
+		}
+	}
+
+	for (i = 0; i < uCount; ++i)
+	{
+		/*the run file is useless after merge*/
+		(void)ExtSort_CloseFile(&pSort->pRunFile[uFirst + i]);
+		free(pRun[i].pRecord);
+	}
+	free(pRun);
+	free(puTree);
+	return nRet;
+}
+
+/*
+ * sort the record file which may be larger than memory
+ * @param const char *pszInput -- the input file name
+ * @param const char *pszOutput -- the output file name
+ * @param EXTSORTCONFIG *pConfig -- the configuration, the default value is used if
+ *									it is NULL or its field is 0
+ * @param COMPAREFUNC CompareFunc -- the comparison function of two records, the
+ *									 length-prefixed record includes its prefix
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT ExternalSort_File(const char *pszInput, const char *pszOutput, EXTSORTCONFIG *pConfig,
+	COMPAREFUNC CompareFunc)
+{
+	EXTSORT Sort;
+	EXTFILE Input, Output, Run;
+	UINT uFirst, uCount, uNewCount, i;
+	INT nRet;
+	if (NULL == pszInput || NULL == pszOutput || NULL == CompareFunc)
+	{
+		return CAPI_FAILED;
+	}
+	Sort.Config.uRecordSize = 0;
+	Sort.Config.uMemorySize = 64 * 1024 * 1024;
+	Sort.Config.uFanIn = 64;
+	Sort.Config.uBufferSize = 1024 * 1024;
+	if (NULL != pConfig)
+	{
+		Sort.Config.uRecordSize = pConfig->uRecordSize;
+		if (0 != pConfig->uMemorySize)
+		{
+			Sort.Config.uMemorySize = pConfig->uMemorySize;
+		}
+		if (pConfig->uFanIn > 1)
+		{
+			Sort.Config.uFanIn = pConfig->uFanIn;
+		}
+		if (0 != pConfig->uBufferSize)
+		{
+			Sort.Config.uBufferSize = pConfig->uBufferSize;
+		}
+	}
+	if (Sort.Config.uMemorySize < 8 * sizeof(void *))
+	{
+		return CAPI_FAILED;
+	}
+	Sort.CompareFunc = CompareFunc;
+	Sort.uRunCount = 0;
+	Sort.uRunMax = 16;
+	Sort.pRunFile = (EXTFILE *)malloc(Sort.uRunMax * sizeof(EXTFILE));
+	if (NULL == Sort.pRunFile)
+	{
+		return CAPI_FAILED;
+	}
+
+	nRet = ExtSort_OpenFile(&Sort, pszInput, "rb", &Input);
+	if (CAPI_SUCCESS == nRet)
+	{
+		nRet = ExtSort_CreateRuns(&Sort, Input.pFile);
+		(void)ExtSort_CloseFile(&Input);
+	}
+
+	/*
+	 * merge each uFanIn adjacent runs into one run until only uFanIn runs remain,
+	 * the order of runs is kept so that the merge is stable
+	 */
+	while (CAPI_SUCCESS == nRet && Sort.uRunCount > Sort.Config.uFanIn)
+	{
+		uNewCount = 0;
+		for (uFirst = 0; uFirst < Sort.uRunCount; uFirst += uCount)
+		{
+			uCount = Sort.uRunCount - uFirst;
+			if (uCount > Sort.Config.uFanIn)
+			{
+				uCount = Sort.Config.uFanIn;
+			}
+			if (1 == uCount)
+			{
+				Sort.pRunFile[uNewCount] = Sort.pRunFile[uFirst];
+				++uNewCount;
+				continue;
+			}
+			if (CAPI_SUCCESS != ExtSort_OpenFile(&Sort, NULL, NULL, &Run))
+			{
+				nRet = CAPI_FAILED;
+				break;
+			}
+			/*the merged runs are closed by ExtSort_MergeRuns*/
+			nRet = ExtSort_MergeRuns(&Sort, uFirst, uCount, Run.pFile);
+			if (CAPI_SUCCESS != nRet || 0 != fflush(Run.pFile))
+			{
+				(void)ExtSort_CloseFile(&Run);
+				uFirst += uCount;
+				nRet = CAPI_FAILED;
+				break;
+			}
+			Sort.pRunFile[uNewCount] = Run;
+			++uNewCount;
+		}
+		if (CAPI_SUCCESS != nRet)
+		{
+			/*close the new runs and the runs which are not merged*/
+			for (i = 0; i < uNewCount; ++i)
+			{
+				(void)ExtSort_CloseFile(&Sort.pRunFile[i]);
+			}
+			for (; uFirst < Sort.uRunCount; ++uFirst)
+			{
+				(void)ExtSort_CloseFile(&Sort.pRunFile[uFirst]);
+			}
+			Sort.uRunCount = 0;
+			break;
+		}
+		Sort.uRunCount = uNewCount;
+	}
+
+	/*the last merge writes into output file*/
+	if (CAPI_SUCCESS == nRet)
+	{
+		nRet = ExtSort_OpenFile(&Sort, pszOutput, "wb", &Output);
+		if (CAPI_SUCCESS == nRet)
+		{
+			if (Sort.uRunCount > 0)
+			{
+				nRet = ExtSort_MergeRuns(&Sort, 0, Sort.uRunCount, Output.pFile);
+				Sort.uRunCount = 0;
+			}
+			if (CAPI_SUCCESS != ExtSort_CloseFile(&Output))
+			{
+				nRet = CAPI_FAILED;
+			}
+		}
+	}
+
+	/*close the runs which are not merged because of error*/
+	for (i = 0; i < Sort.uRunCount; ++i)
+	{
+		(void)ExtSort_CloseFile(&Sort.pRunFile[i]);
+	}
+	free(Sort.pRunFile);
+	return nRet;
+}
@@ -0,0 +1,77 @@
+/*********************************************************************************
+ * FileName:	insertBatch.c
+ * Author:		gehan
+ * Date:		07/12/2017
+ * Description: Insert a batch of data into a sorted table, the batch is sorted and
+ *				merged into the table from the tail in one linear pass
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "introSort.c"
+
+/*
+ * insert a batch of data into sort table and keep it sorted, the table must be
+ * sorted before. It is O(mlogm + n) for m data inserted into n data, and the
+ * inserted data is after the equal data in table
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param void **ppBatch -- the data to insert, the array isn't changed
+ * @param UINT uBatchCount
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return INT -- return CAPI_FAILED if memory is not enough, the table isn't changed
+ */
+INT SortTable_InsertBatch(SORTTABLE *pTable, void **ppBatch, UINT uBatchCount, COMPAREFUNC CompareFunc)
+{
+	SORTTABLE Batch;
+	UINT uTable, uBatch, uWrite;
+	if (NULL == pTable || NULL == CompareFunc || (NULL == ppBatch && 0 != uBatchCount))
+	{
+		return CAPI_FAILED;
+	}
+	if (0 == uBatchCount)
+	{
+		return CAPI_SUCCESS;
+	}
+	if (pTable->uCursorCount + uBatchCount < uBatchCount)
+	{
+		return CAPI_FAILED;
+	}
+	Batch.ppData = (void **)malloc((size_t)uBatchCount * sizeof(void *));
+	if (NULL == Batch.ppData)
+	{
+		return CAPI_FAILED;
+	}
+	if (CAPI_SUCCESS != SortTable_Grow(pTable, pTable->uCursorCount + uBatchCount))
+	{
+		free(Batch.ppData);
+		return CAPI_FAILED;
+	}
+	memcpy(Batch.ppData, ppBatch, uBatchCount * sizeof(void *));
+	Batch.uCursorCount = uBatchCount;
+	Batch.uMaxCount = uBatchCount;
+	SORTSTATS_SHARE(&Batch, pTable);
+	SortTable_IntroSort(&Batch, 0, uBatchCount - 1, CompareFunc);
+
+	/*merge from the tail, so each data is moved at most once*/
+	uTable = pTable->uCursorCount;
+	uBatch = uBatchCount;
+	uWrite = uTable + uBatchCount;
+	while (uBatch > 0)
+	{
+		if (uTable > 0 && SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[uTable - 1],
+			Batch.ppData[uBatch - 1]) > 0)
+		{
+			--uTable;
+			pTable->ppData[--uWrite] = pTable->ppData[uTable];
+		}
+		else
+		{
+			--uBatch;
+			pTable->ppData[--uWrite] = Batch.ppData[uBatch];
+		}
+	}
+	pTable->uCursorCount += uBatchCount;
+	free(Batch.ppData);
+	return CAPI_SUCCESS;
+}
@@ -0,0 +1,373 @@
+/*********************************************************************************
+ * FileName:	introSort.c
+ * Author:		gehan
+ * Date:		07/08/2017
+ * Description: Introspective sort of sort table, it is a quick sort which use
+ *				median-of-three (or ninther) pivot, switch to heap sort when the
+ *				recursion is too deep and use insertion sort for small ranges
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#include "quickSort.c"
+
+/* the range which has less elements than this value will be sorted by insertion sort */
+#define SORTTABLE_INSERTSORT_THRESHOLD	16
+
+/* the range which has more elements than this value will use ninther as pivot */
+#define SORTTABLE_NINTHER_THRESHOLD		128
+
+/*
+ * the insertion sort of sort table, it is fast for small or nearly sorted range
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+void SortTable_InsertSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	UINT i, j;
+	void *pData;
+	for (i = uStart + 1; i <= uEnd; ++i)
+	{
+		pData = pTable->ppData[i];
+		j = i;
+		while (j > uStart && SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[j - 1], pData) > 0)
+		{
+			pTable->ppData[j] = pTable->ppData[j - 1];
+			--j;
+		}
+		pTable->ppData[j] = pData;
+		SORTSTATS_MOVE(pTable, i - j + 1);
+	}
+}
+
+/*
+ * sift down the data at uRoot in a max heap
+ * @param SORTTABLE *pTable	-- the sort table whose stats are counted
+ * @param void **ppBase -- the first data of the heap
+ * @param UINT uRoot
+ * @param UINT uCount -- the data count of the heap
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+static void SortTable_SiftDown(SORTTABLE *pTable, void **ppBase, UINT uRoot, UINT uCount,
+	COMPAREFUNC CompareFunc)
+{
+	void *pData = ppBase[uRoot];
+	UINT uChild;
+	while ((uChild = 2 * uRoot + 1) < uCount)
+	{
+		if (uChild + 1 < uCount && SORTTABLE_COMPARE(pTable, CompareFunc, ppBase[uChild], ppBase[uChild + 1]) < 0)
+		{
+			++uChild;
+		}
+		if (SORTTABLE_COMPARE(pTable, CompareFunc, ppBase[uChild], pData) <= 0)
+		{
+			break;
+		}
+		ppBase[uRoot] = ppBase[uChild];
+		SORTSTATS_MOVE(pTable, 1);
+		uRoot = uChild;
+	}
+	ppBase[uRoot] = pData;
+	SORTSTATS_MOVE(pTable, 1);
+}
+
+/*
+ * the heap sort of sort table, it guarantee O(nlogn) for any input
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+void SortTable_HeapSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	void **ppBase = pTable->ppData + uStart;
+	UINT uCount = uEnd - uStart + 1;
+	UINT i;
+	void *pData;
+	if (uEnd <= uStart)
+	{
+		return;
+	}
+	/*build a max heap*/
+	for (i = uCount / 2; i > 0; --i)
+	{
+		SortTable_SiftDown(pTable, ppBase, i - 1, uCount, CompareFunc);
+	}
+	/*move the max data to the tail one by one*/
+	for (i = uCount - 1; i > 0; --i)
+	{
+		pData = ppBase[0];
+		ppBase[0] = ppBase[i];
+		ppBase[i] = pData;
+		SORTSTATS_MOVE(pTable, 2);
+		SortTable_SiftDown(pTable, ppBase, 0, i, CompareFunc);
+	}
+}
+
+/*
+ * the three-way split function of sort table, it use the first data as pivot.
+ * The data equal to pivot are swapped to both ends while scanning and moved
+ * to the middle at last (Bentley-McIlroy), so it is fast for many equal data.
+ * [uStart, *puLess) is less than pivot, [*puLess, *puGreater] equals to pivot
+ * and (*puGreater, uEnd] is greater than pivot
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @param UINT *puLess -- the first index of data equal to pivot
+ * @param UINT *puGreater -- the last index of data equal to pivot
+ * @return void
+ */
+static void SortTable_Split3(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc,
+	UINT *puLess, UINT *puGreater)
+{
+	void **ppData = pTable->ppData;
+	void *pSelData = ppData[uStart];
+	void *pTemp;
+	UINT uLeft = uStart + 1;	/*[uStart, uLeft) equals to pivot*/
+	UINT uRight = uEnd;			/*(uRight, uEnd] equals to pivot*/
+	UINT i = uStart + 1;
+	UINT j = uEnd;
+	UINT uNum, k;
+	INT nResult;
+
+	for (;;)
+	{
+		while (i <= j && (nResult = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[i], pSelData)) <= 0)
+		{
+			if (0 == nResult)
+			{
+				pTemp = ppData[uLeft];
+				ppData[uLeft] = ppData[i];
+				ppData[i] = pTemp;
+				SORTSTATS_MOVE(pTable, 2);
+				++uLeft;
+			}
+			++i;
+		}
+		while (i <= j && (nResult = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[j], pSelData)) >= 0)
+		{
+			if (0 == nResult)
+			{
+				pTemp = ppData[uRight];
+				ppData[uRight] = ppData[j];
+				ppData[j] = pTemp;
+				SORTSTATS_MOVE(pTable, 2);
+				--uRight;
+			}
+			--j;
+		}
+		if (i > j)
+		{
+			break;
+		}
+		pTemp = ppData[i];
+		ppData[i] = ppData[j];
+		ppData[j] = pTemp;
+		SORTSTATS_MOVE(pTable, 2);
+		++i;
+		--j;
+	}
+
+	/*[uLeft, i) is less than pivot and [i, uRight] is greater than pivot*/
+	uNum = (uLeft - uStart < i - uLeft) ? uLeft - uStart : i - uLeft;
+	SORTSTATS_MOVE(pTable, 2 * uNum);
+	for (k = 0; k < uNum; ++k)
+	{
+		pTemp = ppData[uStart + k];
+		ppData[uStart + k] = ppData[i - uNum + k];
+		ppData[i - uNum + k] = pTemp;
+	}
+	uNum = (uEnd - uRight < uRight + 1 - i) ? uEnd - uRight : uRight + 1 - i;
+	SORTSTATS_MOVE(pTable, 2 * uNum);
+	for (k = 0; k < uNum; ++k)
+	{
+		pTemp = ppData[i + k];
+		ppData[i + k] = ppData[uEnd - uNum + 1 + k];
+		ppData[uEnd - uNum + 1 + k] = pTemp;
+	}
+	*puLess = uStart + (i - uLeft);
+	*puGreater = uEnd - (uRight + 1 - i);
+}
+
+/*
+ * get the index of median data among three data
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uA
+ * @param UINT uB
+ * @param UINT uC
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @param INT *pbEqual -- it is set to 1 if any two compared data are equal
+ * @return UINT -- the index of median data
+ */
+static UINT SortTable_MedianOf3(SORTTABLE *pTable, UINT uA, UINT uB, UINT uC, COMPAREFUNC CompareFunc,
+	INT *pbEqual)
+{
+	void **ppData = pTable->ppData;
+	INT nAB, nBC, nAC;
+	nAB = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uA], ppData[uB]);
+	if (nAB < 0)
+	{
+		nBC = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uB], ppData[uC]);
+		if (nBC < 0)
+		{
+			return uB;
+		}
+		nAC = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uA], ppData[uC]);
+		*pbEqual |= (0 == nBC || 0 == nAC);
+		return nAC < 0 ? uC : uA;
+	}
+	nAC = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uA], ppData[uC]);
+	if (nAC < 0)
+	{
+		*pbEqual |= (0 == nAB);
+		return uA;
+	}
+	nBC = SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uB], ppData[uC]);
+	*pbEqual |= (0 == nAB || 0 == nAC || 0 == nBC);
+	return nBC < 0 ? uC : uB;
+}
+
+/*
+ * choose pivot by median-of-three or ninther, and move it to uStart
+ * so that SortTable_Partition can use it
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return INT -- return 1 if some samples are equal, it means there may be many equal data
+ */
+static INT SortTable_ChoosePivot(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	UINT uCount = uEnd - uStart + 1;
+	UINT uMid = uStart + uCount / 2;
+	UINT uPivot;
+	INT bEqual = 0;
+	void *pData;
+	if (uCount > SORTTABLE_NINTHER_THRESHOLD)
+	{
+		UINT uStep = uCount / 8;
+		UINT uA = SortTable_MedianOf3(pTable, uStart, uStart + uStep, uStart + 2 * uStep, CompareFunc, &bEqual);
+		UINT uB = SortTable_MedianOf3(pTable, uMid - uStep, uMid, uMid + uStep, CompareFunc, &bEqual);
+		UINT uC = SortTable_MedianOf3(pTable, uEnd - 2 * uStep, uEnd - uStep, uEnd, CompareFunc, &bEqual);
+		uPivot = SortTable_MedianOf3(pTable, uA, uB, uC, CompareFunc, &bEqual);
+	}
+	else
+	{
+		uPivot = SortTable_MedianOf3(pTable, uStart, uMid, uEnd, CompareFunc, &bEqual);
+	}
+	pData = pTable->ppData[uStart];
+	pTable->ppData[uStart] = pTable->ppData[uPivot];
+	pTable->ppData[uPivot] = pData;
+	SORTSTATS_MOVE(pTable, 2);
+	return bEqual;
+}
+
+/*
+ * the main loop of introspective sort, it recurse into the smaller part
+ * and loop on the larger part, so the recursion depth is at most logn.
+ * It uses three-way split when the samples of pivot are equal or the pivot
+ * equals to the data before the range, which is not greater than any data
+ * in the range, so the sort of k distinct data is O(nlogk)
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param UINT uDepthLimit -- switch to heap sort when it becomes 0
+ * @param INT bLeftmost -- the range has no data before it
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+static void SortTable_IntroLoop(SORTTABLE *pTable, UINT uStart, UINT uEnd, UINT uDepthLimit,
+	INT bLeftmost, COMPAREFUNC CompareFunc)
+{
+	UINT uMid;
+	UINT uLess, uGreater;
+	INT bEqual;
+	SORTSTATS_ENTER(pTable);
+	while (uEnd - uStart + 1 > SORTTABLE_INSERTSORT_THRESHOLD)
+	{
+		if (0 == uDepthLimit)
+		{
+			SORTSTATS_FALLBACK(pTable);
+			SortTable_HeapSort(pTable, uStart, uEnd, CompareFunc);
+			SORTSTATS_LEAVE(pTable);
+			return;
+		}
+		--uDepthLimit;
+		bEqual = SortTable_ChoosePivot(pTable, uStart, uEnd, CompareFunc);
+		if (!bEqual && !bLeftmost)
+		{
+			bEqual = (0 == SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[uStart - 1],
+				pTable->ppData[uStart]));
+		}
+		if (bEqual)
+		{
+			SortTable_Split3(pTable, uStart, uEnd, CompareFunc, &uLess, &uGreater);
+		}
+		else
+		{
+			uMid = SortTable_Partition(pTable, uStart, uEnd, CompareFunc);
+			uLess = uMid;
+			uGreater = uMid;
+		}
+		SORTSTATS_SPLIT(pTable, uLess - uStart, uEnd - uGreater);
+		if (uLess - uStart < uEnd - uGreater)
+		{
+			if (uLess > uStart + 1)
+			{
+				SortTable_IntroLoop(pTable, uStart, uLess - 1, uDepthLimit, bLeftmost, CompareFunc);
+			}
+			uStart = uGreater + 1;
+			bLeftmost = 0;
+		}
+		else
+		{
+			if (uEnd > uGreater + 1)
+			{
+				SortTable_IntroLoop(pTable, uGreater + 1, uEnd, uDepthLimit, 0, CompareFunc);
+			}
+			if (uLess == uStart)
+			{
+				SORTSTATS_LEAVE(pTable);
+				return;
+			}
+			uEnd = uLess - 1;
+		}
+	}
+	if (uEnd > uStart)
+	{
+		SortTable_InsertSort(pTable, uStart, uEnd, CompareFunc);
+	}
+	SORTSTATS_LEAVE(pTable);
+}
+
+/*
+ * the introspective sort of sort table, it has the same parameters with
+ * SortTable_QuickSort but it is O(nlogn) in the worst case and O(nlogk)
+ * for data with k distinct values
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+void SortTable_IntroSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	UINT uDepthLimit = 0;
+	UINT uCount;
+	if (NULL == pTable || NULL == CompareFunc || uEnd <= uStart)
+	{
+		return;
+	}
+	/*the depth limit is 2*log2(n)*/
+	for (uCount = uEnd - uStart + 1; uCount > 1; uCount >>= 1)
+	{
+		uDepthLimit += 2;
+	}
+	SortTable_IntroLoop(pTable, uStart, uEnd, uDepthLimit, 1, CompareFunc);
+}
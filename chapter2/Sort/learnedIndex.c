@@ -0,0 +1,342 @@
+/*********************************************************************************
+ * FileName:	learnedIndex.c
+ * Author:		gehan
+ * Date:		07/12/2017
+ * Description: Learned index of a sorted table with numeric keys, a linear root model
+ *				chooses a leaf and the linear model of leaf predicts the position,
+ *				the max error of each leaf bounds the last-mile binary search
+**********************************************************************************/
+
+#pragma once
+#include <math.h>
+#include "algo.h"
+#include "quickSort.c"
+
+#define LEARNEDINDEX_KEY_PER_LEAF	4096	/*the default data count of a leaf*/
+#define LEARNEDINDEX_MAX_LEAF		256		/*the default max count of leaves*/
+
+/*
+ * the linear model of leaf, the predicted position of key is
+ * dIntercept + dSlope * (key - uFirstKey)
+ */
+typedef struct LEARNEDLEAF_st {
+	UINT64 uFirstKey;
+	double dSlope;
+	double dIntercept;
+	UINT uStart;		/*the keys of leaf are in [uStart, uEnd) of table*/
+	UINT uEnd;
+	UINT uError;		/*the max distance between predicted and real position*/
+}LEARNEDLEAF;
+
+typedef struct LEARNEDINDEX_st {
+	SORTTABLE *pTable;
+	GETKEY64FUNC GetKeyFunc;
+	LEARNEDLEAF *pLeaf;
+	UINT uLeafCount;
+	UINT64 uMinKey;
+	double dRootScale;	/*the leaf of key is (key - uMinKey) * dRootScale*/
+}LEARNEDINDEX;
+
+/*
+ * get the leaf of key by root model, it is monotone so each leaf has a range of keys
+ * @param LEARNEDINDEX *pIndex
+ * @param UINT64 uKey
+ * @return UINT
+ */
+static UINT LearnedIndex_Root(LEARNEDINDEX *pIndex, UINT64 uKey)
+{
+	double dLeaf;
+	if (uKey <= pIndex->uMinKey)
+	{
+		return 0;
+	}
+	dLeaf = (double)(uKey - pIndex->uMinKey) * pIndex->dRootScale;
+	return dLeaf >= (double)(pIndex->uLeafCount - 1) ? pIndex->uLeafCount - 1 : (UINT)dLeaf;
+}
+
+/*
+ * get the predicted position of key by leaf model
+ * @param LEARNEDLEAF *pLeaf
+ * @param UINT64 uKey
+ * @return double
+ */
+static double LearnedIndex_Predict(LEARNEDLEAF *pLeaf, UINT64 uKey)
+{
+	if (uKey <= pLeaf->uFirstKey)
+	{
+		return pLeaf->dIntercept;
+	}
+	return pLeaf->dIntercept + pLeaf->dSlope * (double)(uKey - pLeaf->uFirstKey);
+}
+
+/*
+ * fit the linear model of leaf by least squares and get its max error
+ * @param LEARNEDINDEX *pIndex
+ * @param LEARNEDLEAF *pLeaf
+ * @return void
+ */
+static void LearnedIndex_Fit(LEARNEDINDEX *pIndex, LEARNEDLEAF *pLeaf)
+{
+	void **ppData = pIndex->pTable->ppData;
+	double dCount = (double)(pLeaf->uEnd - pLeaf->uStart);
+	double dSumX = 0.0, dSumY = 0.0, dSumXX = 0.0, dSumXY = 0.0;
+	double dX, dY, dVar, dError, dMaxError = 0.0;
+	UINT i;
+	pLeaf->dSlope = 0.0;
+	pLeaf->dIntercept = (double)pLeaf->uStart;
+	pLeaf->uError = 0;
+	if (pLeaf->uEnd == pLeaf->uStart)
+	{
+		return;
+	}
+	pLeaf->uFirstKey = (*pIndex->GetKeyFunc)(ppData[pLeaf->uStart]);
+	for (i = pLeaf->uStart; i < pLeaf->uEnd; ++i)
+	{
+		dX = (double)((*pIndex->GetKeyFunc)(ppData[i]) - pLeaf->uFirstKey);
+		dY = (double)(i - pLeaf->uStart);
+		dSumX += dX;
+		dSumY += dY;
+		dSumXX += dX * dX;
+		dSumXY += dX * dY;
+	}
+	dVar = dSumXX - dSumX * dSumX / dCount;
+	if (dVar > 0.0)
+	{
+		pLeaf->dSlope = (dSumXY - dSumX * dSumY / dCount) / dVar;
+	}
+	pLeaf->dIntercept = (double)pLeaf->uStart + (dSumY - pLeaf->dSlope * dSumX) / dCount;
+	for (i = pLeaf->uStart; i < pLeaf->uEnd; ++i)
+	{
+		dError = fabs(LearnedIndex_Predict(pLeaf, (*pIndex->GetKeyFunc)(ppData[i])) - (double)i);
+		dMaxError = dError > dMaxError ? dError : dMaxError;
+	}
+	pLeaf->uError = (UINT)ceil(dMaxError) + 1;
+}
+
+/*
+ * Destroy learned index
+ * @param LEARNEDINDEX *pIndex
+ * @return void
+ */
+void LearnedIndex_Destroy(LEARNEDINDEX *pIndex)
+{
+	if (NULL != pIndex)
+	{
+		free(pIndex->pLeaf);
+		free(pIndex);
+	}
+}
+
+/*
+ * Create learned index of sort table, the table must be sorted in the order of
+ * keys and it must not be changed while the index is used
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param GETKEY64FUNC GetKeyFunc -- the function of get key of data
+ * @param UINT uLeafCount -- the count of leaf models, 0 means the default count
+ * @return LEARNEDINDEX * -- return NULL if failed
+ */
+LEARNEDINDEX * LearnedIndex_Create(SORTTABLE *pTable, GETKEY64FUNC GetKeyFunc, UINT uLeafCount)
+{
+	LEARNEDINDEX *pIndex;
+	UINT64 uMaxKey;
+	UINT uLeaf;
+	UINT i;
+	if (NULL == pTable || NULL == GetKeyFunc)
+	{
+		return NULL;
+	}
+	if (0 == uLeafCount)
+	{
+		uLeafCount = pTable->uCursorCount / LEARNEDINDEX_KEY_PER_LEAF;
+		uLeafCount = uLeafCount > LEARNEDINDEX_MAX_LEAF ? LEARNEDINDEX_MAX_LEAF : uLeafCount;
+		uLeafCount = uLeafCount < 1 ? 1 : uLeafCount;
+	}
+	pIndex = (LEARNEDINDEX *)malloc(sizeof(LEARNEDINDEX));
+	if (NULL == pIndex)
+	{
+		return NULL;
+	}
+	pIndex->pLeaf = (LEARNEDLEAF *)calloc(uLeafCount, sizeof(LEARNEDLEAF));
+	if (NULL == pIndex->pLeaf)
+	{
+		free(pIndex);
+		return NULL;
+	}
+	pIndex->pTable = pTable;
+	pIndex->GetKeyFunc = GetKeyFunc;
+	pIndex->uLeafCount = uLeafCount;
+	pIndex->uMinKey = 0;
+	pIndex->dRootScale = 0.0;
+	if (pTable->uCursorCount > 0)
+	{
+		pIndex->uMinKey = (*GetKeyFunc)(pTable->ppData[0]);
+		uMaxKey = (*GetKeyFunc)(pTable->ppData[pTable->uCursorCount - 1]);
+		if (uMaxKey > pIndex->uMinKey)
+		{
+			pIndex->dRootScale = (double)uLeafCount / ((double)(uMaxKey - pIndex->uMinKey) + 1.0);
+		}
+	}
+
+	/*the keys of each leaf are contiguous since the root model is monotone*/
+	uLeaf = 0;
+	for (i = 0; i < pTable->uCursorCount; ++i)
+	{
+		UINT uTarget = LearnedIndex_Root(pIndex, (*GetKeyFunc)(pTable->ppData[i]));
+		while (uLeaf < uTarget)
+		{
+			pIndex->pLeaf[uLeaf].uEnd = i;
+			++uLeaf;
+			pIndex->pLeaf[uLeaf].uStart = i;
+		}
+	}
+	while (uLeaf < uLeafCount)
+	{
+		pIndex->pLeaf[uLeaf].uEnd = pTable->uCursorCount;
+		++uLeaf;
+		if (uLeaf < uLeafCount)
+		{
+			pIndex->pLeaf[uLeaf].uStart = pTable->uCursorCount;
+		}
+	}
+	for (i = 0; i < uLeafCount; ++i)
+	{
+		LearnedIndex_Fit(pIndex, &pIndex->pLeaf[i]);
+	}
+	return pIndex;
+}
+
+/*
+ * binary search the first key which is not less than uKey in [uLow, uHigh)
+ * @return UINT -- return uHigh if all keys are less than uKey
+ */
+static UINT LearnedIndex_Search(LEARNEDINDEX *pIndex, UINT64 uKey, UINT uLow, UINT uHigh)
+{
+	void **ppData = pIndex->pTable->ppData;
+	UINT uMid;
+	while (uLow < uHigh)
+	{
+		uMid = uLow + (uHigh - uLow) / 2;
+		if ((*pIndex->GetKeyFunc)(ppData[uMid]) < uKey)
+		{
+			uLow = uMid + 1;
+		}
+		else
+		{
+			uHigh = uMid;
+		}
+	}
+	return uLow;
+}
+
+/*
+ * get the index of the first key which is not less than uKey. The search is
+ * bounded by the max error of leaf, and it is widened to the whole leaf if
+ * the result is not confirmed
+ * @param LEARNEDINDEX *pIndex
+ * @param UINT64 uKey
+ * @return UINT -- return uCursorCount if all keys are less than uKey
+ */
+UINT LearnedIndex_LowerBound(LEARNEDINDEX *pIndex, UINT64 uKey)
+{
+	LEARNEDLEAF *pLeaf;
+	double dPredict;
+	UINT uLow, uHigh, uRank;
+	if (NULL == pIndex)
+	{
+		return 0;
+	}
+	/*the answer is in [uStart, uEnd] of the leaf*/
+	pLeaf = &pIndex->pLeaf[LearnedIndex_Root(pIndex, uKey)];
+	dPredict = LearnedIndex_Predict(pLeaf, uKey);
+	uLow = pLeaf->uStart;
+	uHigh = pLeaf->uEnd;
+	/*the model extrapolates far away for the key out of leaf, clamp it before the casts*/
+	if (dPredict < (double)uLow)
+	{
+		dPredict = (double)uLow;
+	}
+	else if (dPredict > (double)uHigh)
+	{
+		dPredict = (double)uHigh;
+	}
+	if (dPredict - (double)pLeaf->uError > (double)uLow)
+	{
+		uLow = (UINT)(dPredict - (double)pLeaf->uError);
+	}
+	if (dPredict + (double)pLeaf->uError + 1.0 < (double)uHigh)
+	{
+		uHigh = (UINT)(dPredict + (double)pLeaf->uError + 1.0);
+	}
+	if (uLow > uHigh)
+	{
+		uLow = uHigh;
+	}
+	uRank = LearnedIndex_Search(pIndex, uKey, uLow, uHigh);
+	if (uRank == uLow && uLow > pLeaf->uStart
+		&& (*pIndex->GetKeyFunc)(pIndex->pTable->ppData[uLow - 1]) >= uKey)
+	{
+		uRank = LearnedIndex_Search(pIndex, uKey, pLeaf->uStart, uLow);
+	}
+	else if (uRank == uHigh && uHigh < pLeaf->uEnd)
+	{
+		uRank = LearnedIndex_Search(pIndex, uKey, uHigh, pLeaf->uEnd);
+	}
+	return uRank;
+}
+
+/*
+ * find the data whose key equals to uKey
+ * @param LEARNEDINDEX *pIndex
+ * @param UINT64 uKey
+ * @return void * -- return match data if successfully, or return NULL
+ */
+void * LearnedIndex_Find(LEARNEDINDEX *pIndex, UINT64 uKey)
+{
+	UINT uRank;
+	if (NULL == pIndex)
+	{
+		return NULL;
+	}
+	uRank = LearnedIndex_LowerBound(pIndex, uKey);
+	if (uRank < pIndex->pTable->uCursorCount
+		&& (*pIndex->GetKeyFunc)(pIndex->pTable->ppData[uRank]) == uKey)
+	{
+		return pIndex->pTable->ppData[uRank];
+	}
+	return NULL;
+}
+
+/*
+ * get the memory size of learned index in bytes, the table isn't included
+ * @param LEARNEDINDEX *pIndex
+ * @return UINT
+ */
+UINT LearnedIndex_ModelSize(LEARNEDINDEX *pIndex)
+{
+	if (NULL == pIndex)
+	{
+		return 0;
+	}
+	return (UINT)(sizeof(LEARNEDINDEX) + pIndex->uLeafCount * sizeof(LEARNEDLEAF));
+}
+
+/*
+ * get the max error of all leaves, the last-mile search checks at most
+ * 2 * error + 1 keys
+ * @param LEARNEDINDEX *pIndex
+ * @return UINT
+ */
+UINT LearnedIndex_MaxError(LEARNEDINDEX *pIndex)
+{
+	UINT uMaxError = 0;
+	UINT i;
+	if (NULL == pIndex)
+	{
+		return 0;
+	}
+	for (i = 0; i < pIndex->uLeafCount; ++i)
+	{
+		uMaxError = pIndex->pLeaf[i].uError > uMaxError ? pIndex->pLeaf[i].uError : uMaxError;
+	}
+	return uMaxError;
+}
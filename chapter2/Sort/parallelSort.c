@@ -0,0 +1,326 @@
+/*********************************************************************************
+ * FileName:	parallelSort.c
+ * Author:		gehan
+ * Date:		07/08/2017
+ * Description: Parallel quick sort of sort table, the pending ranges are kept in
+ *				per-thread deques and the idle thread steals range from others
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#include "introSort.c"
+
+/* the range which has less elements than this value will be sorted sequentially */
+#define SORTTABLE_PARALLEL_CUTOFF	16384
+
+/*
+ * the pending range of sort table
+ */
+typedef struct SORTRANGE_st {
+	UINT uLow;
+	UINT uHigh;
+	UINT uDepthLimit;	/*sort the range sequentially when it becomes 0*/
+}SORTRANGE;
+
+/*
+ * the deque of pending ranges, the owner thread push and pop at the tail
+ * and the other threads steal from the head
+ */
+typedef struct SORTDEQUE_st {
+	SORTRANGE *pRange;
+	UINT uHead;
+	UINT uTail;
+	UINT uMaxCount;
+	LOCK pLock;
+}SORTDEQUE;
+
+/*
+ * the shared data of all sort threads
+ */
+typedef struct SORTPARALLEL_st {
+	SORTTABLE *pTable;
+	COMPAREFUNC CompareFunc;
+	SORTDEQUE *pDeque;			/*one deque for each thread*/
+	UINT uThreadCount;
+	volatile LONG lPending;		/*the count of ranges which are not sorted yet*/
+}SORTPARALLEL;
+
+/*
+ * the argument of sort thread
+ */
+typedef struct SORTWORKER_st {
+	SORTPARALLEL *pParallel;
+	UINT uIndex;				/*the index of its own deque*/
+}SORTWORKER;
+
+/*
+ * push a range into the tail of deque, double size if deque is full
+ * @param SORTDEQUE *pDeque
+ * @param SORTRANGE *pRange
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+static INT SortDeque_PushTail(SORTDEQUE *pDeque, SORTRANGE *pRange)
+{
+	INT nRet = CAPI_SUCCESS;
+	Lock(pDeque->pLock);
+	if (pDeque->uTail == pDeque->uMaxCount)
+	{
+		SORTRANGE *pNewRange = (SORTRANGE *)realloc(pDeque->pRange,
+			pDeque->uMaxCount * 2 * sizeof(SORTRANGE));
+		if (NULL == pNewRange)
+		{
+			nRet = CAPI_FAILED;
+		}
+		else
+		{
+			pDeque->pRange = pNewRange;
+			pDeque->uMaxCount *= 2;
+		}
+	}
+	if (CAPI_SUCCESS == nRet)
+	{
+		pDeque->pRange[pDeque->uTail] = *pRange;
+		++pDeque->uTail;
+	}
+	Unlock(pDeque->pLock);
+	return nRet;
+}
+
+/*
+ * pop a range from the tail (bOwner != 0) or head (bOwner == 0) of deque
+ * @param SORTDEQUE *pDeque
+ * @param INT bOwner -- whether the caller is the owner thread
+ * @param SORTRANGE *pRange -- receive the range
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if deque is empty
+ */
+static INT SortDeque_Pop(SORTDEQUE *pDeque, INT bOwner, SORTRANGE *pRange)
+{
+	INT nRet = CAPI_FAILED;
+	Lock(pDeque->pLock);
+	if (pDeque->uHead != pDeque->uTail)
+	{
+		if (bOwner)
+		{
+			--pDeque->uTail;
+			*pRange = pDeque->pRange[pDeque->uTail];
+		}
+		else
+		{
+			*pRange = pDeque->pRange[pDeque->uHead];
+			++pDeque->uHead;
+		}
+		if (pDeque->uHead == pDeque->uTail)
+		{
+			pDeque->uHead = 0;
+			pDeque->uTail = 0;
+		}
+		nRet = CAPI_SUCCESS;
+	}
+	Unlock(pDeque->pLock);
+	return nRet;
+}
+
+/*
+ * sort a range, split it until it is small enough and push one part
+ * into its own deque so that the idle threads can steal it
+ * @param SORTPARALLEL *pParallel
+ * @param SORTDEQUE *pDeque -- the deque of current thread
+ * @param SORTRANGE *pRange
+ * @return void
+ */
+static void SortTable_ParallelRange(SORTPARALLEL *pParallel, SORTDEQUE *pDeque, SORTRANGE *pRange)
+{
+	SORTTABLE *pTable = pParallel->pTable;
+	SORTRANGE Range = *pRange;
+	SORTRANGE Part;
+	UINT uMid;
+	while (Range.uHigh - Range.uLow + 1 > SORTTABLE_PARALLEL_CUTOFF && Range.uDepthLimit > 0)
+	{
+		--Range.uDepthLimit;
+		(void)SortTable_ChoosePivot(pTable, Range.uLow, Range.uHigh, pParallel->CompareFunc);
+		uMid = SortTable_Partition(pTable, Range.uLow, Range.uHigh, pParallel->CompareFunc);
+		/*push the larger part and continue with the smaller part, the pivot is already in its place*/
+		Part.uDepthLimit = Range.uDepthLimit;
+		if (uMid - Range.uLow < Range.uHigh - uMid)
+		{
+			Part.uLow = uMid + 1;
+			Part.uHigh = Range.uHigh;
+			if (uMid == Range.uLow)
+			{
+				Range = Part;
+				continue;
+			}
+			Range.uHigh = uMid - 1;
+		}
+		else
+		{
+			Part.uLow = Range.uLow;
+			Part.uHigh = uMid - 1;
+			if (uMid == Range.uHigh)
+			{
+				Range = Part;
+				continue;
+			}
+			Range.uLow = uMid + 1;
+		}
+		(void)AtomicIncrement(&pParallel->lPending);
+		if (CAPI_SUCCESS != SortDeque_PushTail(pDeque, &Part))
+		{
+			SortTable_IntroSort(pTable, Part.uLow, Part.uHigh, pParallel->CompareFunc);
+			(void)AtomicDecrement(&pParallel->lPending);
+		}
+	}
+	SortTable_IntroSort(pTable, Range.uLow, Range.uHigh, pParallel->CompareFunc);
+	(void)AtomicDecrement(&pParallel->lPending);
+}
+
+/*
+ * the thread function of parallel sort, it takes range from its own deque
+ * first, and steals from other deques when its own deque is empty
+ * @param void *pArg -- the SORTWORKER pointer
+ * @return THREADRET
+ */
+static THREADRET THREADAPI SortTable_ParallelWorker(void *pArg)
+{
+	SORTWORKER *pWorker = (SORTWORKER *)pArg;
+	SORTPARALLEL *pParallel = pWorker->pParallel;
+	SORTDEQUE *pDeque = &pParallel->pDeque[pWorker->uIndex];
+	SORTRANGE Range;
+	UINT i;
+	while (0 != pParallel->lPending)
+	{
+		if (CAPI_SUCCESS == SortDeque_Pop(pDeque, 1, &Range))
+		{
+			SortTable_ParallelRange(pParallel, pDeque, &Range);
+			continue;
+		}
+		for (i = 1; i < pParallel->uThreadCount; ++i)
+		{
+			UINT uVictim = (pWorker->uIndex + i) % pParallel->uThreadCount;
+			if (CAPI_SUCCESS == SortDeque_Pop(&pParallel->pDeque[uVictim], 0, &Range))
+			{
+				SortTable_ParallelRange(pParallel, pDeque, &Range);
+				break;
+			}
+		}
+		if (i == pParallel->uThreadCount)
+		{
+			ThreadYield();
+		}
+	}
+	return 0;
+}
+
+/*
+ * the parallel quick sort of sort table, the sorted result is the same as
+ * SortTable_IntroSort except the order of equal data
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uThreadCount -- the count of threads including the caller
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT SortTable_ParallelSort(SORTTABLE *pTable, UINT uThreadCount, COMPAREFUNC CompareFunc)
+{
+	SORTPARALLEL Parallel;
+	SORTTABLE Table;
+	SORTWORKER *pWorker;
+	THREAD *pThread;
+	SORTRANGE Range;
+	UINT uCount;
+	UINT i;
+	if (NULL == pTable || NULL == CompareFunc)
+	{
+		return CAPI_FAILED;
+	}
+	if (pTable->uCursorCount < 2)
+	{
+		return CAPI_SUCCESS;
+	}
+	if (uThreadCount < 2 || pTable->uCursorCount <= SORTTABLE_PARALLEL_CUTOFF)
+	{
+		SortTable_IntroSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+		return CAPI_SUCCESS;
+	}
+
+	/*the threads share the table, so they sort a copy without stats*/
+	Table = *pTable;
+	SORTSTATS_INIT(&Table);
+	Parallel.pTable = &Table;
+	Parallel.CompareFunc = CompareFunc;
+	Parallel.uThreadCount = uThreadCount;
+	Parallel.pDeque = (SORTDEQUE *)malloc(uThreadCount * sizeof(SORTDEQUE));
+	pWorker = (SORTWORKER *)malloc(uThreadCount * sizeof(SORTWORKER));
+	pThread = (THREAD *)malloc(uThreadCount * sizeof(THREAD));
+	if (NULL == Parallel.pDeque || NULL == pWorker || NULL == pThread)
+	{
+		free(Parallel.pDeque);
+		free(pWorker);
+		free(pThread);
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uThreadCount; ++i)
+	{
+		Parallel.pDeque[i].uMaxCount = 64;
+		Parallel.pDeque[i].uHead = 0;
+		Parallel.pDeque[i].uTail = 0;
+		Parallel.pDeque[i].pRange = (SORTRANGE *)malloc(64 * sizeof(SORTRANGE));
+		Parallel.pDeque[i].pLock = LockCreate();
+		if (NULL == Parallel.pDeque[i].pRange || NULL == Parallel.pDeque[i].pLock)
+		{
+			break;
+		}
+		pWorker[i].pParallel = &Parallel;
+		pWorker[i].uIndex = i;
+	}
+	if (i < uThreadCount)
+	{
+		for (uCount = 0; uCount <= i; ++uCount)
+		{
+			free(Parallel.pDeque[uCount].pRange);
+			if (NULL != Parallel.pDeque[uCount].pLock)
+			{
+				LockClose(Parallel.pDeque[uCount].pLock);
+			}
+		}
+		free(Parallel.pDeque);
+		free(pWorker);
+		free(pThread);
+		return CAPI_FAILED;
+	}
+
+	/*the depth limit is 2*log2(n), just as SortTable_IntroSort*/
+	Range.uLow = 0;
+	Range.uHigh = pTable->uCursorCount - 1;
+	Range.uDepthLimit = 0;
+	for (uCount = pTable->uCursorCount; uCount > 1; uCount >>= 1)
+	{
+		Range.uDepthLimit += 2;
+	}
+	Parallel.lPending = 1;
+	(void)SortDeque_PushTail(&Parallel.pDeque[0], &Range);
+
+	/*the caller works as the first thread*/
+	for (i = 1; i < uThreadCount; ++i)
+	{
+		pThread[i] = ThreadCreate(SortTable_ParallelWorker, &pWorker[i]);
+	}
+	(void)SortTable_ParallelWorker(&pWorker[0]);
+	for (i = 1; i < uThreadCount; ++i)
+	{
+		if (NULL != pThread[i])
+		{
+			ThreadJoin(pThread[i]);
+			ThreadClose(pThread[i]);
+		}
+	}
+
+	for (i = 0; i < uThreadCount; ++i)
+	{
+		free(Parallel.pDeque[i].pRange);
+		LockClose(Parallel.pDeque[i].pLock);
+	}
+	free(Parallel.pDeque);
+	free(pWorker);
+	free(pThread);
+	return CAPI_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/*********************************************************************************
+ * FileName:	prefixSort.c
+ * Author:		gehan
+ * Date:		07/12/2017
+ * Description: Sort table by cached key prefix, the 8-byte prefixes are packed with
+ *				the data pointers and sorted without accessing the data, only the
+ *				runs of equal prefixes are sorted by the comparison function
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "introSort.c"
+#include "radixSort.c"
+
+/* the range which has more elements than this value is sorted by radix sort */
+#define PREFIXSORT_RADIX_THRESHOLD	65536
+
+/*
+ * get the normalized prefix of a string, the first 8 bytes are packed in
+ * big-endian order so the prefixes have the same order as strcmp
+ * @param const char *pszKey
+ * @return UINT64
+ */
+UINT64 SortKey_StringPrefix(const char *pszKey)
+{
+	UINT64 uKey = 0;
+	UINT i;
+	for (i = 0; i < 8 && '\0' != pszKey[i]; ++i)
+	{
+		uKey |= (UINT64)(unsigned char)pszKey[i] << (56 - 8 * i);
+	}
+	return uKey;
+}
+
+/*
+ * the prefix sort function of sort table. GetPrefixFunc must keep the order of
+ * CompareFunc, that is, the data with less prefix must be less than the other.
+ * The data with equal prefixes are sorted by CompareFunc
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param GETKEY64FUNC GetPrefixFunc -- the function of get key prefix of data
+ * @param COMPAREFUNC CompareFunc -- the comparison function, it can be NULL if the
+ *									 prefix is the whole key
+ * @return INT
+ */
+INT SortTable_PrefixSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, GETKEY64FUNC GetPrefixFunc,
+	COMPAREFUNC CompareFunc)
+{
+	KEYPAIR *pPair;
+	UINT uCount;
+	UINT i, j;
+	if (NULL == pTable || NULL == GetPrefixFunc)
+	{
+		return CAPI_FAILED;
+	}
+	if (uEnd <= uStart)
+	{
+		return CAPI_SUCCESS;
+	}
+	uCount = uEnd - uStart + 1;
+	pPair = (KEYPAIR *)malloc(uCount * sizeof(KEYPAIR));
+	if (NULL == pPair)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		pPair[i].pData = pTable->ppData[uStart + i];
+		pPair[i].uKey = (*GetPrefixFunc)(pPair[i].pData);
+	}
+	if (uCount < PREFIXSORT_RADIX_THRESHOLD || CAPI_SUCCESS != Radix_SortKeyPair(pPair, uCount))
+	{
+		Sort_KeyPair(pPair, uCount);
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		pTable->ppData[uStart + i] = pPair[i].pData;
+	}
+
+	/*only the data with equal prefixes need to be compared*/
+	if (NULL != CompareFunc)
+	{
+		for (i = 0; i < uCount; i = j)
+		{
+			j = i + 1;
+			while (j < uCount && pPair[j].uKey == pPair[i].uKey)
+			{
+				++j;
+			}
+			if (j - i > 1)
+			{
+				SortTable_IntroSort(pTable, uStart + i, uStart + j - 1, CompareFunc);
+			}
+		}
+	}
+	free(pPair);
+	return CAPI_SUCCESS;
+}
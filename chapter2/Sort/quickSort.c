@@ -5,17 +5,119 @@
  * Description: quick sort with recursive method
 **********************************************************************************/
 
+#pragma once
+#include <string.h>
 #include "algo.h"
 
 typedef struct SORTTABLE_st {
 	void **ppData;		/*the pointer array that storage data pointer*/
 	UINT uCursorCount;
 	UINT uMaxCount;
+#if defined(SORTTABLE_STATS)
+	struct SORTSTATS_st *pStats;	/*the stats of sort functions, it can be NULL*/
+#endif
 }SORTTABLE;
 
+/*
+ * define SORTTABLE_STATS to count the work of sort functions into pStats of sort
+ * table, the SORTSTATS_* macros do nothing and cost nothing if it isn't defined.
+ * The parallel sorts and the sorts of primitive keys don't fill the stats
+ */
+#if defined(SORTTABLE_STATS)
+
+/* the split of range which has less elements than this value isn't counted in the imbalance */
+#define SORTSTATS_MIN_SPLIT		16
+
+typedef struct SORTSTATS_st {
+	UINT64 uCompareCount;	/*the calls of comparison function*/
+	UINT64 uMoveCount;		/*the data pointers written into table or temporary buffer*/
+	UINT uDepth;			/*the current depth of recursion or explicit stack*/
+	UINT uMaxDepth;
+	UINT64 uSplitDiff;		/*the sum of |left - right| of splits*/
+	UINT64 uSplitSize;		/*the sum of left + right of splits*/
+	UINT uFallbackCount;	/*the times of heap sort or heap select fallback when pivots are bad*/
+}SORTSTATS;
+
+/*
+ * clear the stats before a sort
+ * @param SORTSTATS *pStats
+ * @return void
+ */
+void SortStats_Reset(SORTSTATS *pStats)
+{
+	if (NULL != pStats)
+	{
+		memset(pStats, 0, sizeof(SORTSTATS));
+	}
+}
+
+static void SortStats_Depth(SORTTABLE *pTable, UINT uDepth)
+{
+	if (NULL != pTable->pStats && uDepth > pTable->pStats->uMaxDepth)
+	{
+		pTable->pStats->uMaxDepth = uDepth;
+	}
+}
+
+static void SortStats_Split(SORTTABLE *pTable, UINT uLeft, UINT uRight)
+{
+	if (NULL == pTable->pStats || uLeft + uRight + 1 < SORTSTATS_MIN_SPLIT)
+	{
+		return;
+	}
+	pTable->pStats->uSplitDiff += uLeft > uRight ? uLeft - uRight : uRight - uLeft;
+	pTable->pStats->uSplitSize += (UINT64)uLeft + uRight;
+}
+
+/*
+ * get the imbalance of splits weighted by range size, the big splits decide
+ * it so a few degenerate splits of small ranges don't. It is about 0.375 for
+ * median-of-three on random data and near 1 when most splits are degenerate
+ * @param SORTSTATS *pStats
+ * @return double -- the sum of |left - right| / the sum of (left + right)
+ */
+double SortStats_Imbalance(SORTSTATS *pStats)
+{
+	if (NULL == pStats || 0 == pStats->uSplitSize)
+	{
+		return 0.0;
+	}
+	return (double)pStats->uSplitDiff / (double)pStats->uSplitSize;
+}
+
+#define SORTTABLE_COMPARE(pTable, CompareFunc, pData1, pData2)							\
+	((NULL != (pTable)->pStats ? ++(pTable)->pStats->uCompareCount : 0), (*(CompareFunc))((pData1), (pData2)))
+#define SORTSTATS_MOVE(pTable, uCount)													\
+	((NULL != (pTable)->pStats) ? (pTable)->pStats->uMoveCount += (uCount) : 0)
+#define SORTSTATS_ENTER(pTable)															\
+	((NULL != (pTable)->pStats) ? SortStats_Depth((pTable), ++(pTable)->pStats->uDepth) : (void)0)
+#define SORTSTATS_LEAVE(pTable)															\
+	((NULL != (pTable)->pStats) ? --(pTable)->pStats->uDepth : 0)
+#define SORTSTATS_DEPTH(pTable, uDepth)		SortStats_Depth((pTable), (uDepth))
+#define SORTSTATS_SPLIT(pTable, uLeft, uRight)	SortStats_Split((pTable), (uLeft), (uRight))
+#define SORTSTATS_FALLBACK(pTable)														\
+	((NULL != (pTable)->pStats) ? ++(pTable)->pStats->uFallbackCount : 0)
+#define SORTSTATS_INIT(pTable)		((pTable)->pStats = NULL)
+#define SORTSTATS_SHARE(pDst, pSrc)	((pDst)->pStats = (pSrc)->pStats)
+
+#else
+
+/* the table is still evaluated so a parameter only used by the stats isn't unused */
+#define SORTTABLE_COMPARE(pTable, CompareFunc, pData1, pData2)	((*(CompareFunc))((pData1), (pData2)))
+#define SORTSTATS_MOVE(pTable, uCount)			((void)(pTable))
+#define SORTSTATS_ENTER(pTable)					((void)(pTable))
+#define SORTSTATS_LEAVE(pTable)					((void)(pTable))
+#define SORTSTATS_DEPTH(pTable, uDepth)			((void)(pTable))
+#define SORTSTATS_SPLIT(pTable, uLeft, uRight)	((void)(pTable))
+#define SORTSTATS_FALLBACK(pTable)				((void)(pTable))
+#define SORTSTATS_INIT(pTable)					((void)(pTable))
+#define SORTSTATS_SHARE(pDst, pSrc)				((void)(pDst), (void)(pSrc))
+
+#endif
+
 /*
  * the constructure of sort table
- * @param UINT uMaxCount
+ * @param UINT uMaxCount -- the initial capacity, the table grows when data is appended
  * @return SORTTABLE *
  */
 SORTTABLE * SortTable_Create(UINT uMaxCount)
@@ -28,12 +130,13 @@ SORTTABLE * SortTable_Create(UINT uMaxCount)
 	pTable = (SORTTABLE *)malloc(sizeof(struct SORTTABLE_st));
 	if (NULL != pTable)
 	{
-		pTable->ppData = (void **)malloc(sizeof(uMaxCount * sizeof(void *)));
+		pTable->ppData = (void **)malloc(uMaxCount * sizeof(void *));
 		if (NULL != pTable->ppData)
 		{
 			pTable->ppData[0] = NULL;
 			pTable->uMaxCount = uMaxCount;
 			pTable->uCursorCount = 0;
+			SORTSTATS_INIT(pTable);
 		}
 		else
 		{
@@ -67,6 +170,97 @@ void SortTable_Destroy(SORTTABLE *pTable, DESTROYFUNC DestroyFunc)
 	}
 }
 
+/* the initial capacity when an empty sort table grows */
+#define SORTTABLE_MIN_GROW		16
+
+/*
+ * make sure the sort table can hold uCount data without reallocation
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uCount
+ * @return INT -- return CAPI_FAILED if memory is not enough, the table isn't changed
+ */
+INT SortTable_Reserve(SORTTABLE *pTable, UINT uCount)
+{
+	void **ppData;
+	size_t uSize;
+	if (NULL == pTable)
+	{
+		return CAPI_FAILED;
+	}
+	if (uCount <= pTable->uMaxCount)
+	{
+		return CAPI_SUCCESS;
+	}
+	uSize = (size_t)uCount * sizeof(void *);
+	if (uSize / sizeof(void *) != uCount)
+	{
+		return CAPI_FAILED;
+	}
+	ppData = (void **)realloc(pTable->ppData, uSize);
+	if (NULL == ppData)
+	{
+		return CAPI_FAILED;
+	}
+	pTable->ppData = ppData;
+	pTable->uMaxCount = uCount;
+	return CAPI_SUCCESS;
+}
+
+/*
+ * make sure the sort table can hold uCount data, the capacity is at least
+ * doubled when it grows so a stream of small growths is amortized O(1)
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uCount
+ * @return INT -- return CAPI_FAILED if memory is not enough, the table isn't changed
+ */
+INT SortTable_Grow(SORTTABLE *pTable, UINT uCount)
+{
+	UINT uMaxCount;
+	if (NULL == pTable)
+	{
+		return CAPI_FAILED;
+	}
+	if (uCount <= pTable->uMaxCount)
+	{
+		return CAPI_SUCCESS;
+	}
+	if (pTable->uMaxCount < SORTTABLE_MIN_GROW)
+	{
+		uMaxCount = SORTTABLE_MIN_GROW;
+	}
+	else if (pTable->uMaxCount > (UINT)-1 / 2)
+	{
+		uMaxCount = (UINT)-1;
+	}
+	else
+	{
+		uMaxCount = pTable->uMaxCount * 2;
+	}
+	return SortTable_Reserve(pTable, uMaxCount > uCount ? uMaxCount : uCount);
+}
+
+/*
+ * append data to the tail of sort table, the capacity is doubled when it is
+ * full so the append is amortized O(1)
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param void *pData
+ * @return INT
+ */
+INT SortTable_Append(SORTTABLE *pTable, void *pData)
+{
+	if (NULL == pTable || (UINT)-1 == pTable->uCursorCount)
+	{
+		return CAPI_FAILED;
+	}
+	if (CAPI_SUCCESS != SortTable_Grow(pTable, pTable->uCursorCount + 1))
+	{
+		return CAPI_FAILED;
+	}
+	pTable->ppData[pTable->uCursorCount] = pData;
+	++pTable->uCursorCount;
+	return CAPI_SUCCESS;
+}
+
 /*
  * the split function of sort table, it use the first data as pivot
  * @param SORTTABLE *pTable	-- the sort table's pointer
@@ -84,7 +278,7 @@ static UINT SortTable_Split(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFU
 
 	while (uLow < uHigh)
 	{
-		while ((*CompareFunc)(pTable->ppData[uHigh], pSelData) > 0
+		while (SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[uHigh], pSelData) > 0
 			&& uLow != uHigh)
 		{
 			--uHigh;
@@ -92,10 +286,11 @@ static UINT SortTable_Split(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFU
 		if (uLow != uHigh)
 		{
 			pTable->ppData[uLow] = pTable->ppData[uHigh];
+			SORTSTATS_MOVE(pTable, 1);
 			++uLow;
 		}
 
-		while ((*CompareFunc)(pTable->ppData[uLow], pSelData) < 0
+		while (SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[uLow], pSelData) < 0
 			&& uLow != uHigh)
 		{
 			++uLow;
@@ -103,13 +298,152 @@ static UINT SortTable_Split(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFU
 		if (uLow != uHigh)
 		{
 			pTable->ppData[uHigh] = pTable->ppData[uLow];
+			SORTSTATS_MOVE(pTable, 1);
 			--uHigh;
 		}
 	}
 	pTable->ppData[uLow] = pSelData;
+	SORTSTATS_MOVE(pTable, 1);
 	return uLow;
 }
 
+/* the block size of SortTable_BlockSplit */
+#define SORTTABLE_BLOCK_SIZE	64
+
+/*
+ * the block split function of sort table, it use the first data as pivot just as
+ * SortTable_Split. It compares the data block by block and saves the offsets of
+ * misplaced data in buffers without branch, then swap them in bulk
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return UINT
+ */
+static UINT SortTable_BlockSplit(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	unsigned char byLeftOffset[SORTTABLE_BLOCK_SIZE];
+	unsigned char byRightOffset[SORTTABLE_BLOCK_SIZE];
+	UINT uLeftNum = 0, uRightNum = 0;
+	UINT uLeftStart = 0, uRightStart = 0;
+	void **ppData = pTable->ppData;
+	void *pSelData = ppData[uStart];
+	void *pTemp;
+	UINT uFirst = uStart + 1;
+	UINT uLast = uEnd + 1;		/*[uFirst, uLast) is not partitioned*/
+	UINT uNum, i;
+
+	while (uLast - uFirst > 2 * SORTTABLE_BLOCK_SIZE)
+	{
+		/*left block saves the data not less than pivot*/
+		if (0 == uLeftNum)
+		{
+			uLeftStart = 0;
+			for (i = 0; i < SORTTABLE_BLOCK_SIZE; ++i)
+			{
+				byLeftOffset[uLeftNum] = (unsigned char)i;
+				uLeftNum += (SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uFirst + i], pSelData) >= 0);
+			}
+		}
+		/*right block saves the data not greater than pivot*/
+		if (0 == uRightNum)
+		{
+			uRightStart = 0;
+			for (i = 0; i < SORTTABLE_BLOCK_SIZE; ++i)
+			{
+				byRightOffset[uRightNum] = (unsigned char)i;
+				uRightNum += (SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uLast - 1 - i], pSelData) <= 0);
+			}
+		}
+		uNum = uLeftNum < uRightNum ? uLeftNum : uRightNum;
+		SORTSTATS_MOVE(pTable, 2 * uNum);
+		for (i = 0; i < uNum; ++i)
+		{
+			UINT uLeft = uFirst + byLeftOffset[uLeftStart + i];
+			UINT uRight = uLast - 1 - byRightOffset[uRightStart + i];
+			pTemp = ppData[uLeft];
+			ppData[uLeft] = ppData[uRight];
+			ppData[uRight] = pTemp;
+		}
+		uLeftNum -= uNum;
+		uRightNum -= uNum;
+		uLeftStart += uNum;
+		uRightStart += uNum;
+		if (0 == uLeftNum)
+		{
+			uFirst += SORTTABLE_BLOCK_SIZE;
+		}
+		if (0 == uRightNum)
+		{
+			uLast -= SORTTABLE_BLOCK_SIZE;
+		}
+	}
+
+	/*the data outside [uFirst, uLast) is in place, partition the rest by normal way*/
+	if (uLast > uFirst)
+	{
+		i = uFirst;
+		uNum = uLast - 1;
+		for (;;)
+		{
+			while (i <= uNum && SORTTABLE_COMPARE(pTable, CompareFunc, ppData[i], pSelData) < 0)
+			{
+				++i;
+			}
+			while (i <= uNum && SORTTABLE_COMPARE(pTable, CompareFunc, ppData[uNum], pSelData) > 0)
+			{
+				--uNum;
+			}
+			if (i >= uNum)
+			{
+				break;
+			}
+			pTemp = ppData[i];
+			ppData[i] = ppData[uNum];
+			ppData[uNum] = pTemp;
+			SORTSTATS_MOVE(pTable, 2);
+			++i;
+			--uNum;
+		}
+		uFirst = i;
+	}
+
+	/*move pivot to the last place of left part*/
+	--uFirst;
+	ppData[uStart] = ppData[uFirst];
+	ppData[uFirst] = pSelData;
+	SORTSTATS_MOVE(pTable, 2);
+	return uFirst;
+}
+
+/*
+ * nonzero to make the quick sort drivers use the block split function, it can be
+ * changed at runtime, and SORTTABLE_BLOCK_PARTITION makes it the default
+ */
+#if defined(SORTTABLE_BLOCK_PARTITION)
+INT g_bSortTableBlockSplit = 1;
+#else
+INT g_bSortTableBlockSplit = 0;
+#endif
+
+/*
+ * the split function used by quick sort drivers, it is SortTable_BlockSplit if
+ * g_bSortTableBlockSplit is nonzero, otherwise SortTable_Split
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return UINT
+ */
+static UINT SortTable_Partition(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	if (g_bSortTableBlockSplit)
+	{
+		return SortTable_BlockSplit(pTable, uStart, uEnd, CompareFunc);
+	}
+	return SortTable_Split(pTable, uStart, uEnd, CompareFunc);
+}
+
 /*
  * the quick sort function of sort table with recusively method
  * @param SORTTABLE *pTable	-- the sort table's pointer
@@ -120,7 +454,9 @@ static UINT SortTable_Split(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFU
  */
 void SortTable_QuickSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
 {
-	UINT uMid = SortTable_Split(pTable, uStart, uEnd, CompareFunc);
+	UINT uMid = SortTable_Partition(pTable, uStart, uEnd, CompareFunc);
+	SORTSTATS_ENTER(pTable);
+	SORTSTATS_SPLIT(pTable, uMid - uStart, uEnd - uMid);
 	if (uMid > uStart)
 	{
 		(void)SortTable_QuickSort(pTable, uStart, uMid - 1, CompareFunc);
@@ -129,4 +465,5 @@ void SortTable_QuickSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC
 	{
 		(void)SortTable_QuickSort(pTable, uMid + 1, uEnd, CompareFunc);
 	}
+	SORTSTATS_LEAVE(pTable);
 }
\ No newline at end of file
@@ -5,8 +5,9 @@
  * Description: The quick sort with non-recursive method
 **********************************************************************************/
 
+#pragma once
 #include "algo.h"
-#include "stack.c"
+#include "../stack/stack.c"
 #include "quickSort.c"
 
 /*
@@ -23,29 +24,41 @@ void SortTable_QuickSort2(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC
 	UINT uLow = uStart;
 	UINT uHigh = uEnd;
 	UINT uMid;
-	pStack = Stack_Create(uHigh - uLow);
-	(void)Stack_Push(pStack, (void *)uLow);
-	(void)Stack_Push(pStack, (void *)uHigh);
-	while (!Stack_IsEmpty(pStack))
+	if (uEnd <= uStart)
 	{
-		uHigh = (UINT)Stack_Pop(pStack);
-		uLow = (UINT)Stack_Pop(pStack);
+		return;
+	}
+	pStack = Stack_Create(uHigh - uLow + 1);
+	if (NULL == pStack)
+	{
+		return;
+	}
+	(void)Stack_Push(pStack, (void *)(size_t)uLow);
+	(void)Stack_Push(pStack, (void *)(size_t)uHigh);
+	/*Stack_IsEmpty returns 0 if the stack is empty*/
+	while (Stack_IsEmpty(pStack))
+	{
+		uHigh = (UINT)(size_t)Stack_Pop(pStack);
+		uLow = (UINT)(size_t)Stack_Pop(pStack);
 		if (uLow < uHigh)
 		{
-			uMid = SortTable_Split(pTable, uLow, uHigh, CompareFunc);
+			uMid = SortTable_Partition(pTable, uLow, uHigh, CompareFunc);
+			SORTSTATS_SPLIT(pTable, uMid - uLow, uHigh - uMid);
 			if (uMid > uLow)
 			{
-				(void)Stack_Push(pStack, (void *)uLow);
-				(void)Stack_Push(pStack, (void *)(uMid - 1));
+				(void)Stack_Push(pStack, (void *)(size_t)uLow);
+				(void)Stack_Push(pStack, (void *)(size_t)(uMid - 1));
 			}
 			if (uHigh > uMid)
 			{
-				(void)Stack_Push(pStack, (void *)(uMid + 1));
-				(void)Stack_Push(pStack, (void *)uHigh);
+				(void)Stack_Push(pStack, (void *)(size_t)(uMid + 1));
+				(void)Stack_Push(pStack, (void *)(size_t)uHigh);
 			}
+			/*each pending range takes two slots of stack*/
+			SORTSTATS_DEPTH(pTable, pStack->uTop / 2);
 		}
-		Stack_Destroy(pStack, NULL);
 	}
+	Stack_Destroy(pStack, NULL);
 }
 
 /*
@@ -63,7 +76,7 @@ void SortTable_QuickSort3(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC
 	UINT uLow = uStart;
 	UINT uHigh = uEnd;
 	UINT uMid;
-	if (uEnd - uStart < 1)
+	if (uEnd <= uStart)
 	{
 		return;
 	}
@@ -71,7 +84,7 @@ void SortTable_QuickSort3(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC
 	puStack = (UINT *)malloc((uHigh - uLow + 1) * sizeof(UINT));
 	if (NULL == puStack)
 	{
-		return CAPI_FAILED;
+		return;
 	}
 	puStack[uStackTop] = uLow;
 	++uStackTop;
@@ -85,7 +98,8 @@ void SortTable_QuickSort3(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC
 		uLow = puStack[uStackTop];
 		if (uLow < uHigh)
 		{
-			uMid = SortTable_Split(pTable, uLow, uHigh, CompareFunc);
+			uMid = SortTable_Partition(pTable, uLow, uHigh, CompareFunc);
+			SORTSTATS_SPLIT(pTable, uMid - uLow, uHigh - uMid);
 			if (uMid - uLow > uHigh - uMid)
 			{
 				puStack[uStackTop] = uLow;
@@ -114,6 +128,7 @@ void SortTable_QuickSort3(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC
 					++uStackTop;
 				}
 			}
+			SORTSTATS_DEPTH(pTable, uStackTop / 2);
 		}
 	}
 	free(puStack);
@@ -0,0 +1,236 @@
+/*********************************************************************************
+ * FileName:	radixSort.c
+ * Author:		gehan
+ * Date:		07/10/2017
+ * Description: LSD radix sort of sort table, the histograms of all digits are
+ *				counted in one pass and the data is scattered between two arrays
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "sortKernel.c"
+
+/*
+ * RadixSort function of sort table, it is stable
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uRadix -- the base of radix sort, the value returned by GetKeyFunc
+ *						 must be less than uRadix
+ * @param UINT uMaxKeyLen -- the count of digits, the 0th digit is the lowest one
+ * @param GETKEYFUNC GetKeyFunc
+ * @return INT
+ */
+INT SortTable_RadixSort(SORTTABLE *pTable, UINT uRadix, UINT uMaxKeyLen, GETKEYFUNC GetKeyFunc)
+{
+	void **ppSrc, **ppDst, **ppTemp;
+	UINT *puCount;
+	UINT *puDigit;
+	UINT uCount;
+	UINT uSum, uTemp;
+	UINT i, j;
+	if (NULL == pTable || NULL == GetKeyFunc || 0 == uRadix)
+	{
+		return CAPI_FAILED;
+	}
+	uCount = pTable->uCursorCount;
+	if (uCount < 2 || 0 == uMaxKeyLen)
+	{
+		return CAPI_SUCCESS;
+	}
+	puCount = (UINT *)calloc(uMaxKeyLen * uRadix, sizeof(UINT));
+	ppDst = (void **)malloc(uCount * sizeof(void *));
+	if (NULL == puCount || NULL == ppDst)
+	{
+		free(puCount);
+		free(ppDst);
+		return CAPI_FAILED;
+	}
+
+	/*count the histograms of all digits in one pass*/
+	for (i = 0; i < uCount; ++i)
+	{
+		puDigit = puCount;
+		for (j = 0; j < uMaxKeyLen; ++j)
+		{
+			++puDigit[(*GetKeyFunc)(pTable->ppData[i], j)];
+			puDigit += uRadix;
+		}
+	}
+
+	ppSrc = pTable->ppData;
+	for (j = 0; j < uMaxKeyLen; ++j)
+	{
+		puDigit = puCount + j * uRadix;
+		/*skip the digit if all data has the same value*/
+		if (puDigit[(*GetKeyFunc)(ppSrc[0], j)] == uCount)
+		{
+			continue;
+		}
+		/*transfer the histogram into the start offset of each box*/
+		uSum = 0;
+		for (i = 0; i < uRadix; ++i)
+		{
+			uTemp = puDigit[i];
+			puDigit[i] = uSum;
+			uSum += uTemp;
+		}
+		for (i = 0; i < uCount; ++i)
+		{
+			ppDst[puDigit[(*GetKeyFunc)(ppSrc[i], j)]++] = ppSrc[i];
+		}
+		ppTemp = ppSrc;
+		ppSrc = ppDst;
+		ppDst = ppTemp;
+	}
+
+	/*the sorted data is in the buffer, move it back into table*/
+	if (ppSrc != pTable->ppData)
+	{
+		memcpy(pTable->ppData, ppSrc, uCount * sizeof(void *));
+		ppDst = ppSrc;
+	}
+	free(ppDst);
+	free(puCount);
+	return CAPI_SUCCESS;
+}
+
+/* the array which isn't more than this count is sorted without histograms */
+#define RADIXSORT_SMALL_THRESHOLD	SORTNET_MAX
+
+/*
+ * generate the byte-wise LSD radix sort function of an array with integer key,
+ * it is INT Name(TYPE *pBase, UINT uCount) and returns CAPI_SUCCESS or CAPI_FAILED
+ * @param Name -- the name of generated function
+ * @param TYPE -- the element type of array
+ * @param KEY -- the macro KEY(a) returns the unsigned integer key of a
+ * @param KEYBYTES -- the byte count of the key
+ * @param SMALLSORT -- the function SMALLSORT(TYPE *pBase, UINT uCount) of small array,
+ *					   it must be stable if the order of equal keys can be seen
+ */
+#define RADIXSORT_DEFINE(Name, TYPE, KEY, KEYBYTES, SMALLSORT)							\
+INT Name(TYPE *pBase, UINT uCount)														\
+{																						\
+	UINT (*puCount)[256];																\
+	TYPE *pSrc, *pDst, *pTemp;															\
+	UINT uSum, uTemp;																	\
+	UINT i, j;																			\
+	if (NULL == pBase)																	\
+	{																					\
+		return CAPI_FAILED;																\
+	}																					\
+	if (uCount < 2)																		\
+	{																					\
+		return CAPI_SUCCESS;															\
+	}																					\
+	if (uCount <= RADIXSORT_SMALL_THRESHOLD)											\
+	{																					\
+		SMALLSORT(pBase, uCount);														\
+		return CAPI_SUCCESS;															\
+	}																					\
+	puCount = (UINT (*)[256])calloc(KEYBYTES, sizeof(*puCount));						\
+	pDst = (TYPE *)malloc(uCount * sizeof(TYPE));										\
+	if (NULL == puCount || NULL == pDst)												\
+	{																					\
+		free(puCount);																	\
+		free(pDst);																		\
+		return CAPI_FAILED;																\
+	}																					\
+	for (i = 0; i < uCount; ++i)														\
+	{																					\
+		for (j = 0; j < KEYBYTES; ++j)													\
+		{																				\
+			++puCount[j][(KEY(pBase[i]) >> (j * 8)) & 0xff];							\
+		}																				\
+	}																					\
+	pSrc = pBase;																		\
+	for (j = 0; j < KEYBYTES; ++j)														\
+	{																					\
+		if (puCount[j][(KEY(pSrc[0]) >> (j * 8)) & 0xff] == uCount)						\
+		{																				\
+			continue;																	\
+		}																				\
+		uSum = 0;																		\
+		for (i = 0; i < 256; ++i)														\
+		{																				\
+			uTemp = puCount[j][i];														\
+			puCount[j][i] = uSum;														\
+			uSum += uTemp;																\
+		}																				\
+		for (i = 0; i < uCount; ++i)													\
+		{																				\
+			pDst[puCount[j][(KEY(pSrc[i]) >> (j * 8)) & 0xff]++] = pSrc[i];			\
+		}																				\
+		pTemp = pSrc;																	\
+		pSrc = pDst;																	\
+		pDst = pTemp;																	\
+	}																					\
+	if (pSrc != pBase)																	\
+	{																					\
+		memcpy(pBase, pSrc, uCount * sizeof(TYPE));										\
+		pDst = pSrc;																	\
+	}																					\
+	free(pDst);																			\
+	free(puCount);																		\
+	return CAPI_SUCCESS;																\
+}
+
+#define RADIXSORT_KEY(a)		(a)
+#define RADIXSORT_KEY_PAIR(a)	((a).uKey)
+
+/*
+ * the fast path of fixed-width integer keys, for example:
+ * INT Radix_SortUInt32(UINT32 *pBase, UINT uCount). The small arrays are sorted
+ * by sorting network or the stable insertion sort
+ */
+RADIXSORT_DEFINE(Radix_SortUInt32, UINT32, RADIXSORT_KEY, 4, SortNet_UInt32)
+RADIXSORT_DEFINE(Radix_SortUInt64, UINT64, RADIXSORT_KEY, 8, Sort_UInt64_InsertSort)
+RADIXSORT_DEFINE(Radix_SortKeyPair, KEYPAIR, RADIXSORT_KEY_PAIR, 8, Sort_KeyPair_InsertSort)
+
+/*
+ * RadixSort function of sort table whose data points to UINT32 (uKeyBytes is 4)
+ * or UINT64 (uKeyBytes is 8), the keys are packed with data pointers first so
+ * that each pass doesn't need to access the data
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uKeyBytes
+ * @return INT
+ */
+INT SortTable_RadixSortUInt(SORTTABLE *pTable, UINT uKeyBytes)
+{
+	KEYPAIR *pPair;
+	UINT i;
+	INT nRet;
+	if (NULL == pTable || (4 != uKeyBytes && 8 != uKeyBytes))
+	{
+		return CAPI_FAILED;
+	}
+	if (pTable->uCursorCount < 2)
+	{
+		return CAPI_SUCCESS;
+	}
+	/*the network keeps the order of equal keys since the keys are packed with indexes*/
+	if (4 == uKeyBytes && pTable->uCursorCount <= SORTNET_MAX)
+	{
+		return SortNet_PtrUInt32(pTable->ppData, pTable->uCursorCount);
+	}
+	pPair = (KEYPAIR *)malloc(pTable->uCursorCount * sizeof(KEYPAIR));
+	if (NULL == pPair)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < pTable->uCursorCount; ++i)
+	{
+		pPair[i].uKey = (4 == uKeyBytes) ? *(UINT32 *)pTable->ppData[i] : *(UINT64 *)pTable->ppData[i];
+		pPair[i].pData = pTable->ppData[i];
+	}
+	/*the passes of high bytes will be skipped for 32-bit keys*/
+	nRet = Radix_SortKeyPair(pPair, pTable->uCursorCount);
+	if (CAPI_SUCCESS == nRet)
+	{
+		for (i = 0; i < pTable->uCursorCount; ++i)
+		{
+			pTable->ppData[i] = pPair[i].pData;
+		}
+	}
+	free(pPair);
+	return nRet;
+}
@@ -0,0 +1,392 @@
+/*********************************************************************************
+ * FileName:	sampleSort.c
+ * Author:		gehan
+ * Date:		07/12/2017
+ * Description: Parallel sample sort of sort table, the splitters are chosen from an
+ *				oversampled and sorted sample, each data is classified into a bucket
+ *				by a splitter tree, then each thread sorts its own buckets which are
+ *				allocated and first touched by itself. If the splitters have equal
+ *				ones, the data equal to a splitter goes to its own equality bucket
+ *				which needn't sorting, so the few distinct keys don't make one big
+ *				bucket
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "introSort.c"
+#include "cpu.c"
+
+#define SAMPLESORT_OVERSAMPLE		16		/*the sample count for each bucket*/
+#define SAMPLESORT_BUCKET_PER_THREAD	4		/*more buckets than threads for load balance*/
+#define SAMPLESORT_MAX_BUCKET		4096
+#define SAMPLESORT_MIN_PER_THREAD	65536	/*the min data count of a thread*/
+#define SAMPLESORT_PAGE_SIZE		4096
+
+/*
+ * the phases of sort threads, the threads are joined between phases
+ */
+typedef enum SAMPLEPHASE_en {
+	SAMPLESORT_CLASSIFY = 0,	/*classify its own part of table and count the histogram*/
+	SAMPLESORT_ALLOCATE,		/*allocate its own buckets*/
+	SAMPLESORT_DISTRIBUTE,		/*move its own part of table into buckets*/
+	SAMPLESORT_SORT				/*sort its own buckets and copy them back*/
+}SAMPLEPHASE;
+
+/*
+ * the shared data of all sort threads
+ */
+typedef struct SAMPLESORT_st {
+	SORTTABLE *pTable;
+	COMPAREFUNC CompareFunc;
+	SAMPLEPHASE Phase;
+	UINT uThreadCount;
+	UINT uLeafCount;			/*the leaves of splitter tree, it is power of 2*/
+	UINT uLogLeaf;
+	UINT uBucketCount;			/*each leaf has a bucket and an equality bucket after it*/
+	void **ppTree;				/*the splitters in Eytzinger order, it starts from 1*/
+	void **ppSplitter;			/*the sorted splitters, the ith one is the upper bound of ith leaf*/
+	INT bEqual;					/*some splitters are equal, so the equality buckets are used*/
+	UINT16 *puBucket;			/*the bucket index of each data*/
+	UINT *puHist;				/*the data count of each thread and each bucket*/
+	UINT *puBucketStart;		/*the index in table of each bucket, there is an extra one at last*/
+	UINT *puFirstBucket;		/*the first bucket of each thread, there is an extra one at last*/
+	void ***pppBucket;			/*the data of each bucket*/
+	INT bFailed;
+}SAMPLESORT;
+
+/*
+ * the argument of sort thread
+ */
+typedef struct SAMPLEWORKER_st {
+	SAMPLESORT *pSort;
+	UINT uIndex;
+}SAMPLEWORKER;
+
+/*
+ * fill the splitter tree by in-order traversal
+ * @param SAMPLESORT *pSort
+ * @param void **ppSplitter -- the sorted splitters
+ * @param UINT uRank -- the index of next splitter
+ * @param UINT uNode
+ * @return UINT -- the index of next splitter after the subtree is filled
+ */
+static UINT SampleSort_BuildTree(SAMPLESORT *pSort, void **ppSplitter, UINT uRank, UINT uNode)
+{
+	if (uNode < pSort->uLeafCount)
+	{
+		uRank = SampleSort_BuildTree(pSort, ppSplitter, uRank, 2 * uNode);
+		pSort->ppTree[uNode] = ppSplitter[uRank];
+		++uRank;
+		uRank = SampleSort_BuildTree(pSort, ppSplitter, uRank, 2 * uNode + 1);
+	}
+	return uRank;
+}
+
+/*
+ * the thread function of sample sort, it does the current phase for its own part
+ * @param void *pArg -- the SAMPLEWORKER pointer
+ * @return THREADRET
+ */
+static THREADRET THREADAPI SampleSort_Worker(void *pArg)
+{
+	SAMPLEWORKER *pWorker = (SAMPLEWORKER *)pArg;
+	SAMPLESORT *pSort = pWorker->pSort;
+	SORTTABLE *pTable = pSort->pTable;
+	UINT uCount = pTable->uCursorCount;
+	UINT uStart = (UINT)((UINT64)uCount * pWorker->uIndex / pSort->uThreadCount);
+	UINT uEnd = (UINT)((UINT64)uCount * (pWorker->uIndex + 1) / pSort->uThreadCount);
+	UINT *puHist = pSort->puHist + pWorker->uIndex * pSort->uBucketCount;
+	UINT uFirst, uLast;
+	SORTTABLE Bucket;
+	UINT uNode, uSize;
+	UINT i, j;
+
+	switch (pSort->Phase)
+	{
+	case SAMPLESORT_CLASSIFY:
+		memset(puHist, 0, pSort->uBucketCount * sizeof(UINT));
+		for (i = uStart; i < uEnd; ++i)
+		{
+			/*go down the splitter tree without branch, the equal data goes left*/
+			uNode = 1;
+			for (j = 0; j < pSort->uLogLeaf; ++j)
+			{
+				uNode = 2 * uNode + ((*pSort->CompareFunc)(pSort->ppTree[uNode], pTable->ppData[i]) < 0);
+			}
+			uNode -= pSort->uLeafCount;
+			/*the data isn't greater than the splitter of its leaf, check if it is equal*/
+			if (pSort->bEqual && uNode + 1 < pSort->uLeafCount
+				&& 0 == (*pSort->CompareFunc)(pSort->ppSplitter[uNode], pTable->ppData[i]))
+			{
+				uNode = 2 * uNode + 1;
+			}
+			else
+			{
+				uNode = 2 * uNode;
+			}
+			pSort->puBucket[i] = (UINT16)uNode;
+			++puHist[uNode];
+		}
+		break;
+
+	case SAMPLESORT_ALLOCATE:
+		/*the pages are placed in the memory near the thread which touches them first*/
+		uFirst = pSort->puFirstBucket[pWorker->uIndex];
+		uLast = pSort->puFirstBucket[pWorker->uIndex + 1];
+		for (i = uFirst; i < uLast; ++i)
+		{
+			uSize = pSort->puBucketStart[i + 1] - pSort->puBucketStart[i];
+			if (0 == uSize)
+			{
+				continue;
+			}
+			pSort->pppBucket[i] = (void **)malloc(uSize * sizeof(void *));
+			if (NULL == pSort->pppBucket[i])
+			{
+				pSort->bFailed = 1;
+				continue;
+			}
+			for (j = 0; j < uSize; j += SAMPLESORT_PAGE_SIZE / sizeof(void *))
+			{
+				pSort->pppBucket[i][j] = NULL;
+			}
+		}
+		break;
+
+	case SAMPLESORT_DISTRIBUTE:
+		/*puHist becomes the write position of this thread in each bucket*/
+		for (i = uStart; i < uEnd; ++i)
+		{
+			j = pSort->puBucket[i];
+			pSort->pppBucket[j][puHist[j]++] = pTable->ppData[i];
+		}
+		break;
+
+	default:
+		uFirst = pSort->puFirstBucket[pWorker->uIndex];
+		uLast = pSort->puFirstBucket[pWorker->uIndex + 1];
+		for (i = uFirst; i < uLast; ++i)
+		{
+			uSize = pSort->puBucketStart[i + 1] - pSort->puBucketStart[i];
+			/*the data in an equality bucket are all equal*/
+			if (uSize > 1 && 0 == (i & 1))
+			{
+				Bucket.ppData = pSort->pppBucket[i];
+				Bucket.uCursorCount = uSize;
+				Bucket.uMaxCount = uSize;
+				SORTSTATS_INIT(&Bucket);
+				SortTable_IntroSort(&Bucket, 0, uSize - 1, pSort->CompareFunc);
+			}
+			if (uSize > 0)
+			{
+				memcpy(pTable->ppData + pSort->puBucketStart[i], pSort->pppBucket[i], uSize * sizeof(void *));
+			}
+		}
+		break;
+	}
+	return 0;
+}
+
+/*
+ * run a phase on all threads and wait for them, the caller works as the first
+ * thread and the part of thread which can't be created is done by the caller
+ * @param SAMPLESORT *pSort
+ * @param SAMPLEWORKER *pWorker
+ * @param THREAD *pThread
+ * @param SAMPLEPHASE Phase
+ * @return void
+ */
+static void SampleSort_RunPhase(SAMPLESORT *pSort, SAMPLEWORKER *pWorker, THREAD *pThread, SAMPLEPHASE Phase)
+{
+	UINT i;
+	pSort->Phase = Phase;
+	for (i = 1; i < pSort->uThreadCount; ++i)
+	{
+		pThread[i] = ThreadCreate(SampleSort_Worker, &pWorker[i]);
+	}
+	(void)SampleSort_Worker(&pWorker[0]);
+	for (i = 1; i < pSort->uThreadCount; ++i)
+	{
+		if (NULL != pThread[i])
+		{
+			ThreadJoin(pThread[i]);
+			ThreadClose(pThread[i]);
+		}
+		else
+		{
+			(void)SampleSort_Worker(&pWorker[i]);
+		}
+	}
+}
+
+/*
+ * choose the splitters from a sorted random sample and build the splitter tree,
+ * the sample is kept as pSort->ppSplitter
+ * @param SAMPLESORT *pSort
+ * @return INT
+ */
+static INT SampleSort_ChooseSplitter(SAMPLESORT *pSort)
+{
+	SORTTABLE Sample;
+	UINT64 uSeed = 88172645463325252ULL;
+	UINT uCount = pSort->uLeafCount * SAMPLESORT_OVERSAMPLE;
+	UINT i;
+	Sample.ppData = (void **)malloc(uCount * sizeof(void *));
+	if (NULL == Sample.ppData)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		uSeed ^= uSeed << 13;
+		uSeed ^= uSeed >> 7;
+		uSeed ^= uSeed << 17;
+		Sample.ppData[i] = pSort->pTable->ppData[uSeed % pSort->pTable->uCursorCount];
+	}
+	Sample.uCursorCount = uCount;
+	Sample.uMaxCount = uCount;
+	SORTSTATS_INIT(&Sample);
+	SortTable_IntroSort(&Sample, 0, uCount - 1, pSort->CompareFunc);
+	/*the ith splitter is the last sample of ith leaf*/
+	for (i = 1; i < pSort->uLeafCount; ++i)
+	{
+		Sample.ppData[i - 1] = Sample.ppData[i * SAMPLESORT_OVERSAMPLE - 1];
+		if (i > 1 && 0 == (*pSort->CompareFunc)(Sample.ppData[i - 2], Sample.ppData[i - 1]))
+		{
+			pSort->bEqual = 1;
+		}
+	}
+	(void)SampleSort_BuildTree(pSort, Sample.ppData, 0, 1);
+	pSort->ppSplitter = Sample.ppData;
+	return CAPI_SUCCESS;
+}
+
+/*
+ * the parallel sample sort of sort table, the sorted result is the same as
+ * SortTable_IntroSort except the order of equal data
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uThreadCount -- the count of threads including the caller,
+ *							   0 means the count of processors
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED, the table is not changed if failed
+ */
+INT SortTable_SampleSort(SORTTABLE *pTable, UINT uThreadCount, COMPAREFUNC CompareFunc)
+{
+	SAMPLESORT Sort;
+	SAMPLEWORKER *pWorker;
+	THREAD *pThread;
+	UINT uSum, uTemp;
+	UINT i, t;
+	INT nRet = CAPI_FAILED;
+	if (NULL == pTable || NULL == CompareFunc)
+	{
+		return CAPI_FAILED;
+	}
+	if (0 == uThreadCount)
+	{
+		uThreadCount = Cpu_GetCount();
+	}
+	if (uThreadCount > pTable->uCursorCount / SAMPLESORT_MIN_PER_THREAD)
+	{
+		uThreadCount = pTable->uCursorCount / SAMPLESORT_MIN_PER_THREAD;
+	}
+	if (uThreadCount < 2)
+	{
+		if (pTable->uCursorCount > 1)
+		{
+			SortTable_IntroSort(pTable, 0, pTable->uCursorCount - 1, CompareFunc);
+		}
+		return CAPI_SUCCESS;
+	}
+
+	memset(&Sort, 0, sizeof(Sort));
+	Sort.pTable = pTable;
+	Sort.CompareFunc = CompareFunc;
+	Sort.uThreadCount = uThreadCount;
+	Sort.uLeafCount = 2;
+	Sort.uLogLeaf = 1;
+	while (Sort.uLeafCount < uThreadCount * SAMPLESORT_BUCKET_PER_THREAD
+		&& Sort.uLeafCount < SAMPLESORT_MAX_BUCKET)
+	{
+		Sort.uLeafCount *= 2;
+		++Sort.uLogLeaf;
+	}
+	Sort.uBucketCount = 2 * Sort.uLeafCount;
+	Sort.ppTree = (void **)malloc(Sort.uLeafCount * sizeof(void *));
+	Sort.puBucket = (UINT16 *)malloc(pTable->uCursorCount * sizeof(UINT16));
+	Sort.puHist = (UINT *)malloc(uThreadCount * Sort.uBucketCount * sizeof(UINT));
+	Sort.puBucketStart = (UINT *)malloc((Sort.uBucketCount + 1) * sizeof(UINT));
+	Sort.puFirstBucket = (UINT *)malloc((uThreadCount + 1) * sizeof(UINT));
+	Sort.pppBucket = (void ***)calloc(Sort.uBucketCount, sizeof(void **));
+	pWorker = (SAMPLEWORKER *)malloc(uThreadCount * sizeof(SAMPLEWORKER));
+	pThread = (THREAD *)malloc(uThreadCount * sizeof(THREAD));
+	if (NULL == Sort.ppTree || NULL == Sort.puBucket || NULL == Sort.puHist || NULL == Sort.puBucketStart
+		|| NULL == Sort.puFirstBucket || NULL == Sort.pppBucket || NULL == pWorker || NULL == pThread
+		|| CAPI_SUCCESS != SampleSort_ChooseSplitter(&Sort))
+	{
+		goto END;
+	}
+	for (i = 0; i < uThreadCount; ++i)
+	{
+		pWorker[i].pSort = &Sort;
+		pWorker[i].uIndex = i;
+	}
+
+	SampleSort_RunPhase(&Sort, pWorker, pThread, SAMPLESORT_CLASSIFY);
+
+	/*get the start of each bucket and the write position of each thread in each bucket*/
+	uSum = 0;
+	for (i = 0; i < Sort.uBucketCount; ++i)
+	{
+		Sort.puBucketStart[i] = uSum;
+		uTemp = 0;
+		for (t = 0; t < uThreadCount; ++t)
+		{
+			uSum += Sort.puHist[t * Sort.uBucketCount + i];
+			Sort.puHist[t * Sort.uBucketCount + i] = uTemp;
+			uTemp = uSum - Sort.puBucketStart[i];
+		}
+	}
+	Sort.puBucketStart[Sort.uBucketCount] = uSum;
+
+	/*the buckets of a thread are contiguous and hold about 1/uThreadCount of data*/
+	Sort.puFirstBucket[0] = 0;
+	for (t = 1, i = 0; t < uThreadCount; ++t)
+	{
+		uTemp = (UINT)((UINT64)uSum * t / uThreadCount);
+		while (i < Sort.uBucketCount && Sort.puBucketStart[i] < uTemp)
+		{
+			++i;
+		}
+		Sort.puFirstBucket[t] = i;
+	}
+	Sort.puFirstBucket[uThreadCount] = Sort.uBucketCount;
+
+	SampleSort_RunPhase(&Sort, pWorker, pThread, SAMPLESORT_ALLOCATE);
+	if (!Sort.bFailed)
+	{
+		SampleSort_RunPhase(&Sort, pWorker, pThread, SAMPLESORT_DISTRIBUTE);
+		SampleSort_RunPhase(&Sort, pWorker, pThread, SAMPLESORT_SORT);
+		nRet = CAPI_SUCCESS;
+	}
+
+END:
+	if (NULL != Sort.pppBucket)
+	{
+		for (i = 0; i < Sort.uBucketCount; ++i)
+		{
+			free(Sort.pppBucket[i]);
+		}
+	}
+	free(Sort.ppTree);
+	free(Sort.ppSplitter);
+	free(Sort.puBucket);
+	free(Sort.puHist);
+	free(Sort.puBucketStart);
+	free(Sort.puFirstBucket);
+	free(Sort.pppBucket);
+	free(pWorker);
+	free(pThread);
+	return nRet;
+}
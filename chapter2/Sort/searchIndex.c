@@ -0,0 +1,187 @@
+/*********************************************************************************
+ * FileName:	searchIndex.c
+ * Author:		gehan
+ * Date:		07/11/2017
+ * Description: Read-only search index of a sorted table, the keys are copied into
+ *				a plain array for branchless binary search and into an Eytzinger
+ *				(BFS order) array whose descendants can be prefetched
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#include "quickSort.c"
+#include "cpu.c"
+
+/* the Eytzinger array is aligned to cache line so that 16 descendants are in 2 lines */
+#define SEARCHINDEX_ALIGN	64
+
+typedef struct SEARCHINDEX_st {
+	UINT64 *puKey;		/*the sorted keys*/
+	UINT64 *puTree;		/*the keys in Eytzinger order, it starts from 1*/
+	UINT *puRank;		/*the index in puKey of each node of puTree*/
+	void **ppData;		/*the data pointers in sorted order*/
+	void *pTreeBuf;		/*the allocated buffer of puTree*/
+	UINT uCount;
+}SEARCHINDEX;
+
+/*
+ * fill the subtree of node uNode by in-order traversal
+ * @param SEARCHINDEX *pIndex
+ * @param UINT uRank -- the index of next key in puKey
+ * @param UINT uNode -- the node of puTree
+ * @return UINT -- the index of next key after the subtree is filled
+ */
+static UINT SearchIndex_Build(SEARCHINDEX *pIndex, UINT uRank, UINT uNode)
+{
+	if (uNode <= pIndex->uCount)
+	{
+		uRank = SearchIndex_Build(pIndex, uRank, 2 * uNode);
+		pIndex->puTree[uNode] = pIndex->puKey[uRank];
+		pIndex->puRank[uNode] = uRank;
+		++uRank;
+		uRank = SearchIndex_Build(pIndex, uRank, 2 * uNode + 1);
+	}
+	return uRank;
+}
+
+/*
+ * Destroy search index
+ * @param SEARCHINDEX *pIndex
+ * @return void
+ */
+void SearchIndex_Destroy(SEARCHINDEX *pIndex)
+{
+	if (NULL == pIndex)
+	{
+		return;
+	}
+	free(pIndex->puKey);
+	free(pIndex->pTreeBuf);
+	free(pIndex->puRank);
+	free(pIndex->ppData);
+	free(pIndex);
+}
+
+/*
+ * Create search index from a sort table, the table must be sorted in the order of
+ * the keys and uCursorCount must be less than 2^31. The table can be changed or
+ * destroyed after the index is created
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param GETKEY64FUNC GetKeyFunc -- the function of get key of data
+ * @return SEARCHINDEX * -- return NULL if failed
+ */
+SEARCHINDEX * SearchIndex_Create(SORTTABLE *pTable, GETKEY64FUNC GetKeyFunc)
+{
+	SEARCHINDEX *pIndex;
+	UINT uCount;
+	UINT i;
+	if (NULL == pTable || NULL == GetKeyFunc)
+	{
+		return NULL;
+	}
+	pIndex = (SEARCHINDEX *)calloc(1, sizeof(SEARCHINDEX));
+	if (NULL == pIndex)
+	{
+		return NULL;
+	}
+	uCount = pTable->uCursorCount;
+	pIndex->uCount = uCount;
+	pIndex->puKey = (UINT64 *)malloc((uCount + 1) * sizeof(UINT64));
+	pIndex->pTreeBuf = malloc((uCount + 1) * sizeof(UINT64) + SEARCHINDEX_ALIGN);
+	pIndex->puRank = (UINT *)malloc((uCount + 1) * sizeof(UINT));
+	pIndex->ppData = (void **)malloc((uCount + 1) * sizeof(void *));
+	if (NULL == pIndex->puKey || NULL == pIndex->pTreeBuf || NULL == pIndex->puRank
+		|| NULL == pIndex->ppData)
+	{
+		SearchIndex_Destroy(pIndex);
+		return NULL;
+	}
+	pIndex->puTree = (UINT64 *)(((size_t)pIndex->pTreeBuf + SEARCHINDEX_ALIGN - 1)
+		& ~(size_t)(SEARCHINDEX_ALIGN - 1));
+	for (i = 0; i < uCount; ++i)
+	{
+		pIndex->ppData[i] = pTable->ppData[i];
+		pIndex->puKey[i] = (*GetKeyFunc)(pTable->ppData[i]);
+	}
+	(void)SearchIndex_Build(pIndex, 0, 1);
+	return pIndex;
+}
+
+/*
+ * get the index of the first key which is not less than uKey in the sorted keys,
+ * the loop has no branch except the loop condition and both possible next
+ * middle keys are prefetched
+ * @param SEARCHINDEX *pIndex
+ * @param UINT64 uKey
+ * @return UINT -- return uCount if all keys are less than uKey
+ */
+UINT SearchIndex_LowerBound(SEARCHINDEX *pIndex, UINT64 uKey)
+{
+	const UINT64 *puBase;
+	UINT uCount, uHalf;
+	if (NULL == pIndex || 0 == pIndex->uCount)
+	{
+		return 0;
+	}
+	puBase = pIndex->puKey;
+	uCount = pIndex->uCount;
+	while (uCount > 1)
+	{
+		uHalf = uCount / 2;
+		Prefetch(puBase + uHalf / 2);
+		Prefetch(puBase + uHalf + uHalf / 2);
+		puBase = (puBase[uHalf] < uKey) ? puBase + uHalf : puBase;
+		uCount -= uHalf;
+	}
+	return (UINT)(puBase - pIndex->puKey) + (*puBase < uKey);
+}
+
+/*
+ * the same as SearchIndex_LowerBound but search in the Eytzinger array, the
+ * descendants of four levels below are prefetched in each step
+ * @param SEARCHINDEX *pIndex
+ * @param UINT64 uKey
+ * @return UINT -- return uCount if all keys are less than uKey
+ */
+UINT SearchIndex_EytzingerLowerBound(SEARCHINDEX *pIndex, UINT64 uKey)
+{
+	const UINT64 *puTree;
+	UINT uNode, uCount;
+	if (NULL == pIndex)
+	{
+		return 0;
+	}
+	puTree = pIndex->puTree;
+	uCount = pIndex->uCount;
+	uNode = 1;
+	while (uNode <= uCount)
+	{
+		Prefetch(puTree + (size_t)uNode * 16);
+		Prefetch(puTree + (size_t)uNode * 16 + 8);
+		uNode = 2 * uNode + (puTree[uNode] < uKey);
+	}
+	/*remove the right turns after the last left turn, it is the answer node*/
+	uNode >>= Cpu_TrailingZero(~uNode) + 1;
+	return 0 == uNode ? uCount : pIndex->puRank[uNode];
+}
+
+/*
+ * find the data whose key equals to uKey
+ * @param SEARCHINDEX *pIndex
+ * @param UINT64 uKey
+ * @return void * -- return match data if successfully, or return NULL
+ */
+void * SearchIndex_Find(SEARCHINDEX *pIndex, UINT64 uKey)
+{
+	UINT uRank;
+	if (NULL == pIndex)
+	{
+		return NULL;
+	}
+	uRank = SearchIndex_EytzingerLowerBound(pIndex, uKey);
+	if (uRank < pIndex->uCount && pIndex->puKey[uRank] == uKey)
+	{
+		return pIndex->ppData[uRank];
+	}
+	return NULL;
+}
@@ -0,0 +1,236 @@
+/*********************************************************************************
+ * FileName:	selection.c
+ * Author:		gehan
+ * Date:		07/10/2017
+ * Description: Selection and partial sort of sort table, they use the same split
+ *				function as quick sort and switch to heap when the pivots are bad
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#include "introSort.c"
+
+/*
+ * select the smallest (uMiddle - uStart + 1) data into [uStart, uMiddle] by a max heap,
+ * the greatest of them is at uStart. It is O(nlogk)
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uMiddle
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+static void SortTable_HeapSelect(SORTTABLE *pTable, UINT uStart, UINT uMiddle, UINT uEnd,
+	COMPAREFUNC CompareFunc)
+{
+	void **ppBase = pTable->ppData + uStart;
+	UINT uCount = uMiddle - uStart + 1;
+	UINT i;
+	void *pData;
+	for (i = uCount / 2; i > 0; --i)
+	{
+		SortTable_SiftDown(pTable, ppBase, i - 1, uCount, CompareFunc);
+	}
+	for (i = uMiddle + 1; i <= uEnd; ++i)
+	{
+		if (SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[i], ppBase[0]) < 0)
+		{
+			pData = ppBase[0];
+			ppBase[0] = pTable->ppData[i];
+			pTable->ppData[i] = pData;
+			SORTSTATS_MOVE(pTable, 2);
+			SortTable_SiftDown(pTable, ppBase, 0, uCount, CompareFunc);
+		}
+	}
+}
+
+/*
+ * put the data which should be at uNth after sort into uNth, and the data
+ * before it is not greater than it, the data after it is not less than it.
+ * It is expected O(n), and O(nlogn) when the pivots are always bad
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param UINT uNth -- the index in [uStart, uEnd]
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+void SortTable_NthElement(SORTTABLE *pTable, UINT uStart, UINT uEnd, UINT uNth, COMPAREFUNC CompareFunc)
+{
+	UINT uDepthLimit = 0;
+	UINT uCount;
+	UINT uLess, uGreater;
+	INT bEqual;
+	INT bLeftmost = 1;
+	void *pData;
+	if (NULL == pTable || NULL == CompareFunc || uEnd <= uStart || uNth < uStart || uNth > uEnd)
+	{
+		return;
+	}
+	for (uCount = uEnd - uStart + 1; uCount > 1; uCount >>= 1)
+	{
+		uDepthLimit += 2;
+	}
+	while (uEnd - uStart + 1 > SORTTABLE_INSERTSORT_THRESHOLD)
+	{
+		if (0 == uDepthLimit)
+		{
+			/*the max of heap is the nth data*/
+			SORTSTATS_FALLBACK(pTable);
+			SortTable_HeapSelect(pTable, uStart, uNth, uEnd, CompareFunc);
+			pData = pTable->ppData[uStart];
+			pTable->ppData[uStart] = pTable->ppData[uNth];
+			pTable->ppData[uNth] = pData;
+			SORTSTATS_MOVE(pTable, 2);
+			return;
+		}
+		--uDepthLimit;
+		/*use three-way split for many equal data just as SortTable_IntroLoop*/
+		bEqual = SortTable_ChoosePivot(pTable, uStart, uEnd, CompareFunc);
+		if (!bEqual && !bLeftmost)
+		{
+			bEqual = (0 == SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[uStart - 1],
+				pTable->ppData[uStart]));
+		}
+		if (bEqual)
+		{
+			SortTable_Split3(pTable, uStart, uEnd, CompareFunc, &uLess, &uGreater);
+		}
+		else
+		{
+			uLess = SortTable_Partition(pTable, uStart, uEnd, CompareFunc);
+			uGreater = uLess;
+		}
+		SORTSTATS_SPLIT(pTable, uLess - uStart, uEnd - uGreater);
+		if (uNth >= uLess && uNth <= uGreater)
+		{
+			return;
+		}
+		if (uNth < uLess)
+		{
+			uEnd = uLess - 1;
+		}
+		else
+		{
+			uStart = uGreater + 1;
+			bLeftmost = 0;
+		}
+	}
+	if (uEnd > uStart)
+	{
+		SortTable_InsertSort(pTable, uStart, uEnd, CompareFunc);
+	}
+}
+
+/*
+ * sort the smallest uK data into [uStart, uStart + uK) and the rest data is in
+ * any order, it is expected O(n + klogk)
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param UINT uK
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+void SortTable_PartialSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, UINT uK, COMPAREFUNC CompareFunc)
+{
+	if (NULL == pTable || NULL == CompareFunc || uEnd <= uStart || 0 == uK)
+	{
+		return;
+	}
+	if (uK > uEnd - uStart)
+	{
+		SortTable_IntroSort(pTable, uStart, uEnd, CompareFunc);
+		return;
+	}
+	SortTable_NthElement(pTable, uStart, uEnd, uStart + uK - 1, CompareFunc);
+	if (uK > 2)
+	{
+		SortTable_IntroSort(pTable, uStart, uStart + uK - 2, CompareFunc);
+	}
+}
+
+/*
+ * sift down the data at uRoot in a min heap
+ * @param SORTTABLE *pTable	-- the sort table whose stats are counted
+ * @param void **ppBase -- the first data of the heap
+ * @param UINT uRoot
+ * @param UINT uCount -- the data count of the heap
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return void
+ */
+static void SortTable_MinSiftDown(SORTTABLE *pTable, void **ppBase, UINT uRoot, UINT uCount,
+	COMPAREFUNC CompareFunc)
+{
+	void *pData = ppBase[uRoot];
+	UINT uChild;
+	while ((uChild = 2 * uRoot + 1) < uCount)
+	{
+		if (uChild + 1 < uCount && SORTTABLE_COMPARE(pTable, CompareFunc, ppBase[uChild + 1], ppBase[uChild]) < 0)
+		{
+			++uChild;
+		}
+		if (SORTTABLE_COMPARE(pTable, CompareFunc, pData, ppBase[uChild]) <= 0)
+		{
+			break;
+		}
+		ppBase[uRoot] = ppBase[uChild];
+		SORTSTATS_MOVE(pTable, 1);
+		uRoot = uChild;
+	}
+	ppBase[uRoot] = pData;
+	SORTSTATS_MOVE(pTable, 1);
+}
+
+/*
+ * get the greatest uK data of sort table in descending order by a min heap,
+ * the table isn't modified. It is O(nlogk)
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uK
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @param void **ppResult -- the buffer of result, its size must be at least uK
+ * @return UINT -- the count of data in ppResult
+ */
+UINT SortTable_TopK(SORTTABLE *pTable, UINT uK, COMPAREFUNC CompareFunc, void **ppResult)
+{
+	UINT uCount, i;
+	void *pData;
+	if (NULL == pTable || NULL == CompareFunc || NULL == ppResult)
+	{
+		return 0;
+	}
+	uCount = uK < pTable->uCursorCount ? uK : pTable->uCursorCount;
+	if (0 == uCount)
+	{
+		return 0;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		ppResult[i] = pTable->ppData[i];
+	}
+	SORTSTATS_MOVE(pTable, uCount);
+	for (i = uCount / 2; i > 0; --i)
+	{
+		SortTable_MinSiftDown(pTable, ppResult, i - 1, uCount, CompareFunc);
+	}
+	/*the top of min heap is the smallest one of current top k*/
+	for (i = uCount; i < pTable->uCursorCount; ++i)
+	{
+		if (SORTTABLE_COMPARE(pTable, CompareFunc, pTable->ppData[i], ppResult[0]) > 0)
+		{
+			ppResult[0] = pTable->ppData[i];
+			SORTSTATS_MOVE(pTable, 1);
+			SortTable_MinSiftDown(pTable, ppResult, 0, uCount, CompareFunc);
+		}
+	}
+	/*move the min data to the tail one by one, so the result is descending*/
+	for (i = uCount - 1; i > 0; --i)
+	{
+		pData = ppResult[0];
+		ppResult[0] = ppResult[i];
+		ppResult[i] = pData;
+		SORTSTATS_MOVE(pTable, 2);
+		SortTable_MinSiftDown(pTable, ppResult, 0, i, CompareFunc);
+	}
+	return uCount;
+}
@@ -0,0 +1,551 @@
+/*********************************************************************************
+ * FileName:	setOperation.c
+ * Author:		gehan
+ * Date:		07/19/2017
+ * Description: Set operations of sorted sort tables, the intersection, union and
+ *				difference are merged linearly when the tables have similar
+ *				sizes, and the larger table is searched by galloping when the
+ *				sizes are skewed. The intersection of UINT32 arrays compares
+ *				4 keys with 4 keys at a time by SSE
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "quickSort.c"
+#include "cpu.c"
+
+/* the larger table is searched by galloping if it is this times of the smaller one */
+#define SETOP_GALLOP_RATIO		16
+
+/*
+ * find the first data which is not less than pKey by galloping search,
+ * the steps grow by 2 times from uStart, so it costs O(log(d)) where d is
+ * the distance to the result
+ * @param void **ppData
+ * @param UINT uStart
+ * @param UINT uEnd -- the end of range, it is not included
+ * @param void *pKey
+ * @param COMPAREFUNC CompareFunc
+ * @return UINT -- the index of data, return uEnd if all data are less than pKey
+ */
+static UINT SetOp_Gallop(void **ppData, UINT uStart, UINT uEnd, void *pKey, COMPAREFUNC CompareFunc)
+{
+	UINT uLow, uHigh, uMid, uStep;
+	if (uStart >= uEnd || (*CompareFunc)(ppData[uStart], pKey) >= 0)
+	{
+		return uStart;
+	}
+	/*the data at uLow is always less than pKey*/
+	uLow = uStart;
+	uStep = 1;
+	while (uStep < uEnd - uLow && (*CompareFunc)(ppData[uLow + uStep], pKey) < 0)
+	{
+		uLow += uStep;
+		uStep <<= 1;
+	}
+	uHigh = uStep < uEnd - uLow ? uLow + uStep : uEnd;
+	while (uLow + 1 < uHigh)
+	{
+		uMid = uLow + (uHigh - uLow) / 2;
+		if ((*CompareFunc)(ppData[uMid], pKey) < 0)
+		{
+			uLow = uMid;
+		}
+		else
+		{
+			uHigh = uMid;
+		}
+	}
+	return uHigh;
+}
+
+/*
+ * the intersection of two sorted tables, the equal data of pTable1 are saved.
+ * The tables may have repeated data, each data matches one equal data of the
+ * other table
+ * @param SORTTABLE *pTable1
+ * @param SORTTABLE *pTable2
+ * @param SORTTABLE *pOutput -- the table to receive result, its old data are
+ *								discarded. It is not reallocated if it can hold
+ *								the smaller table, and it can be pTable1 but
+ *								can't be pTable2
+ * @param COMPAREFUNC CompareFunc
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT SortTable_Intersect(SORTTABLE *pTable1, SORTTABLE *pTable2, SORTTABLE *pOutput, COMPAREFUNC CompareFunc)
+{
+	SORTTABLE *pSmall, *pLarge;
+	UINT uCount1, uCount2;
+	UINT i, j, k;
+	INT nRet;
+	if (NULL == pTable1 || NULL == pTable2 || NULL == pOutput || NULL == CompareFunc || pOutput == pTable2)
+	{
+		return CAPI_FAILED;
+	}
+	uCount1 = pTable1->uCursorCount;
+	uCount2 = pTable2->uCursorCount;
+	if (CAPI_SUCCESS != SortTable_Reserve(pOutput, uCount1 < uCount2 ? uCount1 : uCount2))
+	{
+		return CAPI_FAILED;
+	}
+
+	k = 0;
+	if (uCount1 / SETOP_GALLOP_RATIO >= uCount2 || uCount2 / SETOP_GALLOP_RATIO >= uCount1)
+	{
+		/*each data of the smaller table is searched in the larger table*/
+		pSmall = uCount1 < uCount2 ? pTable1 : pTable2;
+		pLarge = uCount1 < uCount2 ? pTable2 : pTable1;
+		j = 0;
+		for (i = 0; i < pSmall->uCursorCount && j < pLarge->uCursorCount; ++i)
+		{
+			j = SetOp_Gallop(pLarge->ppData, j, pLarge->uCursorCount, pSmall->ppData[i], CompareFunc);
+			if (j < pLarge->uCursorCount && 0 == (*CompareFunc)(pLarge->ppData[j], pSmall->ppData[i]))
+			{
+				pOutput->ppData[k++] = pSmall == pTable1 ? pSmall->ppData[i] : pLarge->ppData[j];
+				++j;
+			}
+		}
+	}
+	else
+	{
+		i = 0;
+		j = 0;
+		while (i < uCount1 && j < uCount2)
+		{
+			nRet = (*CompareFunc)(pTable1->ppData[i], pTable2->ppData[j]);
+			if (nRet < 0)
+			{
+				++i;
+			}
+			else if (nRet > 0)
+			{
+				++j;
+			}
+			else
+			{
+				pOutput->ppData[k++] = pTable1->ppData[i];
+				++i;
+				++j;
+			}
+		}
+	}
+	pOutput->uCursorCount = k;
+	return CAPI_SUCCESS;
+}
+
+/*
+ * the union of two sorted tables, the equal data of pTable1 are saved.
+ * The tables may have repeated data, each data matches one equal data of the
+ * other table
+ * @param SORTTABLE *pTable1
+ * @param SORTTABLE *pTable2
+ * @param SORTTABLE *pOutput -- the table to receive result, its old data are
+ *								discarded. It is not reallocated if it can hold
+ *								both tables, and it can't be pTable1 or pTable2
+ * @param COMPAREFUNC CompareFunc
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT SortTable_Union(SORTTABLE *pTable1, SORTTABLE *pTable2, SORTTABLE *pOutput, COMPAREFUNC CompareFunc)
+{
+	SORTTABLE *pSmall, *pLarge;
+	UINT uCount1, uCount2;
+	UINT i, j, k, uNext;
+	INT nRet;
+	if (NULL == pTable1 || NULL == pTable2 || NULL == pOutput || NULL == CompareFunc
+		|| pOutput == pTable1 || pOutput == pTable2)
+	{
+		return CAPI_FAILED;
+	}
+	uCount1 = pTable1->uCursorCount;
+	uCount2 = pTable2->uCursorCount;
+	if (uCount1 + uCount2 < uCount1 || CAPI_SUCCESS != SortTable_Reserve(pOutput, uCount1 + uCount2))
+	{
+		return CAPI_FAILED;
+	}
+
+	k = 0;
+	if (uCount1 / SETOP_GALLOP_RATIO >= uCount2 || uCount2 / SETOP_GALLOP_RATIO >= uCount1)
+	{
+		/*the data of larger table before each data of smaller table are copied in a block*/
+		pSmall = uCount1 < uCount2 ? pTable1 : pTable2;
+		pLarge = uCount1 < uCount2 ? pTable2 : pTable1;
+		j = 0;
+		for (i = 0; i < pSmall->uCursorCount; ++i)
+		{
+			uNext = SetOp_Gallop(pLarge->ppData, j, pLarge->uCursorCount, pSmall->ppData[i], CompareFunc);
+			memcpy(pOutput->ppData + k, pLarge->ppData + j, (uNext - j) * sizeof(void *));
+			k += uNext - j;
+			j = uNext;
+			if (j < pLarge->uCursorCount && 0 == (*CompareFunc)(pLarge->ppData[j], pSmall->ppData[i]))
+			{
+				pOutput->ppData[k++] = pSmall == pTable1 ? pSmall->ppData[i] : pLarge->ppData[j];
+				++j;
+			}
+			else
+			{
+				pOutput->ppData[k++] = pSmall->ppData[i];
+			}
+		}
+		memcpy(pOutput->ppData + k, pLarge->ppData + j, (pLarge->uCursorCount - j) * sizeof(void *));
+		k += pLarge->uCursorCount - j;
+	}
+	else
+	{
+		i = 0;
+		j = 0;
+		while (i < uCount1 && j < uCount2)
+		{
+			nRet = (*CompareFunc)(pTable1->ppData[i], pTable2->ppData[j]);
+			if (nRet < 0)
+			{
+				pOutput->ppData[k++] = pTable1->ppData[i++];
+			}
+			else if (nRet > 0)
+			{
+				pOutput->ppData[k++] = pTable2->ppData[j++];
+			}
+			else
+			{
+				pOutput->ppData[k++] = pTable1->ppData[i];
+				++i;
+				++j;
+			}
+		}
+		memcpy(pOutput->ppData + k, pTable1->ppData + i, (uCount1 - i) * sizeof(void *));
+		k += uCount1 - i;
+		memcpy(pOutput->ppData + k, pTable2->ppData + j, (uCount2 - j) * sizeof(void *));
+		k += uCount2 - j;
+	}
+	pOutput->uCursorCount = k;
+	return CAPI_SUCCESS;
+}
+
+/*
+ * the difference of two sorted tables, that is the data of pTable1 which are
+ * not in pTable2. The tables may have repeated data, each data of pTable2
+ * removes one equal data of pTable1
+ * @param SORTTABLE *pTable1
+ * @param SORTTABLE *pTable2
+ * @param SORTTABLE *pOutput -- the table to receive result, its old data are
+ *								discarded. It is not reallocated if it can hold
+ *								pTable1, and it can be pTable1
+ * @param COMPAREFUNC CompareFunc
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT SortTable_Difference(SORTTABLE *pTable1, SORTTABLE *pTable2, SORTTABLE *pOutput, COMPAREFUNC CompareFunc)
+{
+	UINT uCount1, uCount2;
+	UINT i, j, k, uNext;
+	INT nRet;
+	if (NULL == pTable1 || NULL == pTable2 || NULL == pOutput || NULL == CompareFunc || pOutput == pTable2)
+	{
+		return CAPI_FAILED;
+	}
+	uCount1 = pTable1->uCursorCount;
+	uCount2 = pTable2->uCursorCount;
+	if (CAPI_SUCCESS != SortTable_Reserve(pOutput, uCount1))
+	{
+		return CAPI_FAILED;
+	}
+
+	k = 0;
+	i = 0;
+	j = 0;
+	if (uCount1 / SETOP_GALLOP_RATIO >= uCount2)
+	{
+		/*the data of pTable1 between two removed data are moved in a block*/
+		for (j = 0; j < uCount2 && i < uCount1; ++j)
+		{
+			uNext = SetOp_Gallop(pTable1->ppData, i, uCount1, pTable2->ppData[j], CompareFunc);
+			memmove(pOutput->ppData + k, pTable1->ppData + i, (uNext - i) * sizeof(void *));
+			k += uNext - i;
+			i = uNext;
+			if (i < uCount1 && 0 == (*CompareFunc)(pTable1->ppData[i], pTable2->ppData[j]))
+			{
+				++i;
+			}
+		}
+	}
+	else if (uCount2 / SETOP_GALLOP_RATIO >= uCount1)
+	{
+		/*each data of pTable1 is searched in pTable2*/
+		for (i = 0; i < uCount1; ++i)
+		{
+			j = SetOp_Gallop(pTable2->ppData, j, uCount2, pTable1->ppData[i], CompareFunc);
+			if (j < uCount2 && 0 == (*CompareFunc)(pTable2->ppData[j], pTable1->ppData[i]))
+			{
+				++j;
+			}
+			else
+			{
+				pOutput->ppData[k++] = pTable1->ppData[i];
+			}
+		}
+	}
+	else
+	{
+		while (i < uCount1 && j < uCount2)
+		{
+			nRet = (*CompareFunc)(pTable1->ppData[i], pTable2->ppData[j]);
+			if (nRet < 0)
+			{
+				pOutput->ppData[k++] = pTable1->ppData[i++];
+			}
+			else
+			{
+				if (0 == nRet)
+				{
+					++i;
+				}
+				++j;
+			}
+		}
+	}
+	/*the rest data of pTable1 are greater than all data of pTable2*/
+	memmove(pOutput->ppData + k, pTable1->ppData + i, (uCount1 - i) * sizeof(void *));
+	k += uCount1 - i;
+	pOutput->uCursorCount = k;
+	return CAPI_SUCCESS;
+}
+
+/*
+ * the intersection of k sorted tables, the smaller tables are intersected
+ * first so the result shrinks quickly and the larger tables are searched by
+ * galloping. The equal data of the first table in ppTable are saved
+ * @param SORTTABLE **ppTable -- the array of tables
+ * @param UINT uTableCount
+ * @param SORTTABLE *pOutput -- the table to receive result, it can't be any of ppTable
+ * @param COMPAREFUNC CompareFunc
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT SortTable_IntersectK(SORTTABLE **ppTable, UINT uTableCount, SORTTABLE *pOutput, COMPAREFUNC CompareFunc)
+{
+	SORTTABLE **ppOrder;
+	SORTTABLE *pTable;
+	UINT i, j;
+	INT nRet = CAPI_SUCCESS;
+	if (NULL == ppTable || 0 == uTableCount || NULL == pOutput || NULL == CompareFunc)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uTableCount; ++i)
+	{
+		if (NULL == ppTable[i] || pOutput == ppTable[i])
+		{
+			return CAPI_FAILED;
+		}
+	}
+	if (1 == uTableCount)
+	{
+		if (CAPI_SUCCESS != SortTable_Reserve(pOutput, ppTable[0]->uCursorCount))
+		{
+			return CAPI_FAILED;
+		}
+		memcpy(pOutput->ppData, ppTable[0]->ppData, ppTable[0]->uCursorCount * sizeof(void *));
+		pOutput->uCursorCount = ppTable[0]->uCursorCount;
+		return CAPI_SUCCESS;
+	}
+
+	/*sort the other tables by size, the first table is kept first so its data are saved*/
+	ppOrder = (SORTTABLE **)malloc(uTableCount * sizeof(SORTTABLE *));
+	if (NULL == ppOrder)
+	{
+		return CAPI_FAILED;
+	}
+	ppOrder[0] = ppTable[0];
+	for (i = 1; i < uTableCount; ++i)
+	{
+		pTable = ppTable[i];
+		j = i;
+		while (j > 1 && ppOrder[j - 1]->uCursorCount > pTable->uCursorCount)
+		{
+			ppOrder[j] = ppOrder[j - 1];
+			--j;
+		}
+		ppOrder[j] = pTable;
+	}
+
+	nRet = SortTable_Intersect(ppOrder[0], ppOrder[1], pOutput, CompareFunc);
+	for (i = 2; i < uTableCount && CAPI_SUCCESS == nRet && pOutput->uCursorCount > 0; ++i)
+	{
+		nRet = SortTable_Intersect(pOutput, ppOrder[i], pOutput, CompareFunc);
+	}
+	free(ppOrder);
+	return nRet;
+}
+
+#if defined(CPU_X86)
+/*
+ * the byte shuffles which move the matched keys to the front, indexed by the
+ * mask of matched keys
+ */
+static const unsigned char s_aucSetOpShuffle[16][16] = {
+	{ 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 4, 5, 6, 7, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 4, 5, 6, 7, 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80 },
+	{ 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 4, 5, 6, 7, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80 },
+	{ 8, 9, 10, 11, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 8, 9, 10, 11, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80 },
+	{ 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+};
+
+/*
+ * intersect the blocks of 4 keys by SSE, each block of puA is compared with
+ * all rotations of the block of puB, and the block which has less max key
+ * is skipped
+ * @param UINT *puIndexA -- receive the index of the rest keys of puA
+ * @param UINT *puIndexB -- receive the index of the rest keys of puB
+ * @return UINT -- the count of keys saved into puOut
+ */
+static CPU_TARGET_SSE41 UINT SetOp_IntersectUInt32Sse41(const UINT32 *puA, UINT uCountA, const UINT32 *puB,
+	UINT uCountB, UINT32 *puOut, UINT *puIndexA, UINT *puIndexB)
+{
+	__m128i A, B, Match;
+	UINT uLimit = uCountA < uCountB ? uCountA : uCountB;
+	UINT32 uMaxA, uMaxB;
+	UINT i = 0, j = 0, k = 0;
+	INT nMask;
+	/*4 keys are stored in each step, so it stops before the end of puOut*/
+	while (i + 4 <= uCountA && j + 4 <= uCountB && k + 4 <= uLimit)
+	{
+		A = _mm_loadu_si128((const __m128i *)(puA + i));
+		B = _mm_loadu_si128((const __m128i *)(puB + j));
+		Match = _mm_cmpeq_epi32(A, B);
+		Match = _mm_or_si128(Match, _mm_cmpeq_epi32(A, _mm_shuffle_epi32(B, _MM_SHUFFLE(0, 3, 2, 1))));
+		Match = _mm_or_si128(Match, _mm_cmpeq_epi32(A, _mm_shuffle_epi32(B, _MM_SHUFFLE(1, 0, 3, 2))));
+		Match = _mm_or_si128(Match, _mm_cmpeq_epi32(A, _mm_shuffle_epi32(B, _MM_SHUFFLE(2, 1, 0, 3))));
+		nMask = _mm_movemask_ps(_mm_castsi128_ps(Match));
+		_mm_storeu_si128((__m128i *)(puOut + k),
+			_mm_shuffle_epi8(A, _mm_loadu_si128((const __m128i *)s_aucSetOpShuffle[nMask])));
+		k += (nMask & 1) + ((nMask >> 1) & 1) + ((nMask >> 2) & 1) + ((nMask >> 3) & 1);
+		/*the steps are computed without branch since they are hard to predict*/
+		uMaxA = puA[i + 3];
+		uMaxB = puB[j + 3];
+		i += (uMaxA <= uMaxB) << 2;
+		j += (uMaxB <= uMaxA) << 2;
+	}
+	*puIndexA = i;
+	*puIndexB = j;
+	return k;
+}
+#endif
+
+/*
+ * find the first key which is not less than uKey by galloping search
+ * @param const UINT32 *puKey
+ * @param UINT uStart
+ * @param UINT uEnd -- the end of range, it is not included
+ * @param UINT32 uKey
+ * @return UINT -- the index of key, return uEnd if all keys are less than uKey
+ */
+static UINT SetOp_GallopUInt32(const UINT32 *puKey, UINT uStart, UINT uEnd, UINT32 uKey)
+{
+	UINT uLow, uHigh, uMid, uStep;
+	if (uStart >= uEnd || puKey[uStart] >= uKey)
+	{
+		return uStart;
+	}
+	uLow = uStart;
+	uStep = 1;
+	while (uStep < uEnd - uLow && puKey[uLow + uStep] < uKey)
+	{
+		uLow += uStep;
+		uStep <<= 1;
+	}
+	uHigh = uStep < uEnd - uLow ? uLow + uStep : uEnd;
+	while (uLow + 1 < uHigh)
+	{
+		uMid = uLow + (uHigh - uLow) / 2;
+		if (puKey[uMid] < uKey)
+		{
+			uLow = uMid;
+		}
+		else
+		{
+			uHigh = uMid;
+		}
+	}
+	return uHigh;
+}
+
+/*
+ * the intersection of two sorted UINT32 arrays, such as the ID lists. The keys
+ * of each array must be strictly increasing
+ * @param const UINT32 *puA
+ * @param UINT uCountA
+ * @param const UINT32 *puB
+ * @param UINT uCountB
+ * @param UINT32 *puOut -- the buffer of result, it can hold min(uCountA, uCountB)
+ *						   keys and doesn't overlap the arrays
+ * @return UINT -- the count of keys saved into puOut
+ */
+UINT SetOp_IntersectUInt32(const UINT32 *puA, UINT uCountA, const UINT32 *puB, UINT uCountB, UINT32 *puOut)
+{
+	const UINT32 *puTemp;
+	UINT i = 0, j = 0, k = 0;
+	if (NULL == puA || NULL == puB || NULL == puOut)
+	{
+		return 0;
+	}
+	if (uCountA > uCountB)
+	{
+		puTemp = puA;
+		puA = puB;
+		puB = puTemp;
+		i = uCountA;
+		uCountA = uCountB;
+		uCountB = i;
+		i = 0;
+	}
+
+	/*each key of the smaller array is searched in the larger array*/
+	if (uCountB / SETOP_GALLOP_RATIO >= uCountA)
+	{
+		for (i = 0; i < uCountA && j < uCountB; ++i)
+		{
+			j = SetOp_GallopUInt32(puB, j, uCountB, puA[i]);
+			if (j < uCountB && puB[j] == puA[i])
+			{
+				puOut[k++] = puA[i];
+				++j;
+			}
+		}
+		return k;
+	}
+
+#if defined(CPU_X86)
+	if (Cpu_GetFeatures() & CPU_FEATURE_SSE41)
+	{
+		k = SetOp_IntersectUInt32Sse41(puA, uCountA, puB, uCountB, puOut, &i, &j);
+	}
+#endif
+	/*the keys which are matched in the blocks are never matched again here*/
+	while (i < uCountA && j < uCountB)
+	{
+		if (puA[i] < puB[j])
+		{
+			++i;
+		}
+		else if (puA[i] > puB[j])
+		{
+			++j;
+		}
+		else
+		{
+			puOut[k++] = puA[i];
+			++i;
+			++j;
+		}
+	}
+	return k;
+}
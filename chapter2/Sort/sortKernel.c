@@ -0,0 +1,251 @@
+/*********************************************************************************
+ * FileName:	sortKernel.c
+ * Author:		gehan
+ * Date:		07/08/2017
+ * Description: Specialized introspective sort for primitive keys, the sort functions
+ *				are generated by macro so that the comparison is inlined instead of
+ *				calling COMPAREFUNC through pointer
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "quickSort.c"
+#include "sortNetwork.c"
+
+/* the range which has less elements than this value will be sorted by insertion sort */
+#define SORTKERNEL_INSERTSORT_THRESHOLD	24
+
+/*
+ * the (key, payload) pair, the key should be transferred by SortKey_* functions
+ * if it is not unsigned integer
+ */
+typedef struct KEYPAIR_st {
+	UINT64 uKey;
+	void *pData;
+}KEYPAIR;
+
+/*
+ * generate the insertion sort function of an array, it is the default sort of
+ * small range and the baseline of sorting network
+ * @param Name -- the name prefix, the function is void Name##_InsertSort(TYPE *pBase, UINT uCount)
+ * @param TYPE -- the element type of array
+ * @param LESS -- the macro LESS(a, b) returns nonzero if a is less than b
+ */
+#define SORTKERNEL_DEFINE_INSERTSORT(Name, TYPE, LESS)									\
+static void Name##_InsertSort(TYPE *pBase, UINT uCount)								\
+{																						\
+	UINT i, j;																			\
+	TYPE Data;																			\
+	for (i = 1; i < uCount; ++i)														\
+	{																					\
+		Data = pBase[i];																\
+		for (j = i; j > 0 && LESS(Data, pBase[j - 1]); --j)							\
+		{																				\
+			pBase[j] = pBase[j - 1];													\
+		}																				\
+		pBase[j] = Data;																\
+	}																					\
+}
+
+/*
+ * generate the introspective sort function of an array
+ * @param Name -- the name of generated function, it is void Name(TYPE *pBase, UINT uCount)
+ * @param TYPE -- the element type of array
+ * @param LESS -- the macro LESS(a, b) returns nonzero if a is less than b
+ * @param THRESHOLD -- the range which isn't more than it is sorted by SMALLSORT
+ * @param SMALLSORT -- the function SMALLSORT(TYPE *pBase, UINT uCount) of small range
+ */
+#define SORTKERNEL_DEFINE_EX(Name, TYPE, LESS, THRESHOLD, SMALLSORT)					\
+static void Name##_SiftDown(TYPE *pBase, UINT uRoot, UINT uSize)						\
+{																						\
+	UINT uChild;																		\
+	TYPE Data = pBase[uRoot];															\
+	while ((uChild = 2 * uRoot + 1) < uSize)											\
+	{																					\
+		if (uChild + 1 < uSize && LESS(pBase[uChild], pBase[uChild + 1]))				\
+		{																				\
+			++uChild;																	\
+		}																				\
+		if (!LESS(Data, pBase[uChild]))													\
+		{																				\
+			break;																		\
+		}																				\
+		pBase[uRoot] = pBase[uChild];													\
+		uRoot = uChild;																	\
+	}																					\
+	pBase[uRoot] = Data;																\
+}																						\
+static void Name##_HeapSort(TYPE *pBase, UINT uCount)									\
+{																						\
+	UINT i;																				\
+	TYPE Data;																			\
+	for (i = uCount / 2; i > 0; --i)													\
+	{																					\
+		Name##_SiftDown(pBase, i - 1, uCount);											\
+	}																					\
+	for (i = uCount - 1; i > 0; --i)													\
+	{																					\
+		Data = pBase[0]; pBase[0] = pBase[i]; pBase[i] = Data;							\
+		Name##_SiftDown(pBase, 0, i);													\
+	}																					\
+}																						\
+static void Name##_IntroLoop(TYPE *pBase, UINT uCount, UINT uDepthLimit)				\
+{																						\
+	UINT i, j;																			\
+	TYPE Pivot;																			\
+	TYPE Data;																			\
+	while (uCount > THRESHOLD)															\
+	{																					\
+		if (0 == uDepthLimit)															\
+		{																				\
+			Name##_HeapSort(pBase, uCount);												\
+			return;																		\
+		}																				\
+		--uDepthLimit;																	\
+		/*median-of-three, the first and last data become sentinels*/					\
+		i = uCount / 2;																	\
+		j = uCount - 1;																	\
+		if (LESS(pBase[i], pBase[0]))													\
+		{																				\
+			Data = pBase[i]; pBase[i] = pBase[0]; pBase[0] = Data;						\
+		}																				\
+		if (LESS(pBase[j], pBase[i]))													\
+		{																				\
+			Data = pBase[j]; pBase[j] = pBase[i]; pBase[i] = Data;						\
+			if (LESS(pBase[i], pBase[0]))												\
+			{																			\
+				Data = pBase[i]; pBase[i] = pBase[0]; pBase[0] = Data;					\
+			}																			\
+		}																				\
+		Pivot = pBase[i];																\
+		i = 0;																			\
+		for (;;)																		\
+		{																				\
+			while (LESS(pBase[i], Pivot))												\
+			{																			\
+				++i;																	\
+			}																			\
+			while (LESS(Pivot, pBase[j]))												\
+			{																			\
+				--j;																	\
+			}																			\
+			if (i >= j)																	\
+			{																			\
+				break;																	\
+			}																			\
+			Data = pBase[i]; pBase[i] = pBase[j]; pBase[j] = Data;						\
+			++i;																		\
+			--j;																		\
+		}																				\
+		/*[0, j] is not greater than pivot and [j+1, uCount) is not less than pivot*/	\
+		++j;																			\
+		if (j < uCount - j)																\
+		{																				\
+			Name##_IntroLoop(pBase, j, uDepthLimit);									\
+			pBase += j;																	\
+			uCount -= j;																\
+		}																				\
+		else																			\
+		{																				\
+			Name##_IntroLoop(pBase + j, uCount - j, uDepthLimit);						\
+			uCount = j;																	\
+		}																				\
+	}																					\
+	SMALLSORT(pBase, uCount);															\
+}																						\
+void Name(TYPE *pBase, UINT uCount)													\
+{																						\
+	UINT uDepthLimit = 0;																\
+	UINT i;																				\
+	if (NULL == pBase || uCount < 2)													\
+	{																					\
+		return;																			\
+	}																					\
+	for (i = uCount; i > 1; i >>= 1)													\
+	{																					\
+		uDepthLimit += 2;																\
+	}																					\
+	Name##_IntroLoop(pBase, uCount, uDepthLimit);										\
+}
+
+#define SORTKERNEL_DEFINE(Name, TYPE, LESS)												\
+	SORTKERNEL_DEFINE_INSERTSORT(Name, TYPE, LESS)										\
+	SORTKERNEL_DEFINE_EX(Name, TYPE, LESS, SORTKERNEL_INSERTSORT_THRESHOLD, Name##_InsertSort)
+
+#define SORTKERNEL_LESS(a, b)			((a) < (b))
+#define SORTKERNEL_LESS_PAIR(a, b)		((a).uKey < (b).uKey)
+#define SORTKERNEL_LESS_INT32(a, b)		(*(INT32 *)(a) < *(INT32 *)(b))
+#define SORTKERNEL_LESS_UINT32(a, b)	(*(UINT32 *)(a) < *(UINT32 *)(b))
+#define SORTKERNEL_LESS_INT64(a, b)		(*(INT64 *)(a) < *(INT64 *)(b))
+#define SORTKERNEL_LESS_UINT64(a, b)	(*(UINT64 *)(a) < *(UINT64 *)(b))
+#define SORTKERNEL_LESS_DOUBLE(a, b)	(*(double *)(a) < *(double *)(b))
+#define SORTKERNEL_LESS_FLOAT(a, b)		(*(float *)(a) < *(float *)(b))
+
+/*
+ * sort the packed key array, for example: void Sort_Int32(INT32 *pBase, UINT uCount),
+ * the order of NaN is undefined in Sort_Double and Sort_Float. The small ranges of
+ * 32-bit and INT64 keys are sorted by sorting network
+ */
+SORTKERNEL_DEFINE_EX(Sort_Int32, INT32, SORTKERNEL_LESS, SORTNET_THRESHOLD, SortNet_Int32)
+SORTKERNEL_DEFINE_EX(Sort_UInt32, UINT32, SORTKERNEL_LESS, SORTNET_THRESHOLD, SortNet_UInt32)
+SORTKERNEL_DEFINE_EX(Sort_Int64, INT64, SORTKERNEL_LESS, SORTNET_THRESHOLD, SortNet_Int64)
+SORTKERNEL_DEFINE(Sort_UInt64, UINT64, SORTKERNEL_LESS)
+SORTKERNEL_DEFINE(Sort_Double, double, SORTKERNEL_LESS)
+SORTKERNEL_DEFINE_EX(Sort_Float, float, SORTKERNEL_LESS, SORTNET_THRESHOLD, SortNet_Float)
+SORTKERNEL_DEFINE(Sort_KeyPair, KEYPAIR, SORTKERNEL_LESS_PAIR)
+
+/*
+ * sort the pointer array whose data is the key, for example:
+ * void SortPtr_Int32(void **ppBase, UINT uCount), the small ranges of 32-bit
+ * keys are sorted by sorting network with the indexes of pointers
+ */
+SORTKERNEL_DEFINE_EX(SortPtr_Int32, void *, SORTKERNEL_LESS_INT32, SORTNET_THRESHOLD, SortNet_PtrInt32)
+SORTKERNEL_DEFINE_EX(SortPtr_UInt32, void *, SORTKERNEL_LESS_UINT32, SORTNET_THRESHOLD, SortNet_PtrUInt32)
+SORTKERNEL_DEFINE(SortPtr_Int64, void *, SORTKERNEL_LESS_INT64)
+SORTKERNEL_DEFINE(SortPtr_UInt64, void *, SORTKERNEL_LESS_UINT64)
+SORTKERNEL_DEFINE(SortPtr_Double, void *, SORTKERNEL_LESS_DOUBLE)
+SORTKERNEL_DEFINE_EX(SortPtr_Float, void *, SORTKERNEL_LESS_FLOAT, SORTNET_THRESHOLD, SortNet_PtrFloat)
+
+/*
+ * generate the sort function of sort table whose data points to the key,
+ * for example: void SortTable_SortInt32(SORTTABLE *pTable, UINT uStart, UINT uEnd)
+ */
+#define SORTKERNEL_DEFINE_TABLE(Type)													\
+void SortTable_Sort##Type(SORTTABLE *pTable, UINT uStart, UINT uEnd)					\
+{																						\
+	if (NULL != pTable && uEnd > uStart)												\
+	{																					\
+		SortPtr_##Type(pTable->ppData + uStart, uEnd - uStart + 1);						\
+	}																					\
+}
+
+SORTKERNEL_DEFINE_TABLE(Int32)
+SORTKERNEL_DEFINE_TABLE(UInt32)
+SORTKERNEL_DEFINE_TABLE(Int64)
+SORTKERNEL_DEFINE_TABLE(UInt64)
+SORTKERNEL_DEFINE_TABLE(Double)
+SORTKERNEL_DEFINE_TABLE(Float)
+
+/*
+ * transfer signed integer to unsigned key with the same order
+ * @param INT64 nKey
+ * @return UINT64
+ */
+UINT64 SortKey_Int64(INT64 nKey)
+{
+	return (UINT64)nKey ^ ((UINT64)1 << 63);
+}
+
+/*
+ * transfer double to unsigned key with the same order, -0.0 is less than 0.0
+ * @param double dKey
+ * @return UINT64
+ */
+UINT64 SortKey_Double(double dKey)
+{
+	UINT64 uKey;
+	memcpy(&uKey, &dKey, sizeof(uKey));
+	/*flip all bits of negative number and only the sign bit of positive number*/
+	return uKey ^ ((UINT64)(0 - (uKey >> 63)) | ((UINT64)1 << 63));
+}
@@ -0,0 +1,488 @@
+/*********************************************************************************
+ * FileName:	sortNetwork.c
+ * Author:		gehan
+ * Date:		07/12/2017
+ * Description: Sorting networks of small key arrays, the keys are sorted by bitonic
+ *				network in AVX2 or SSE4.1 registers, and by odd-even merge network
+ *				with branchless compare-exchange if SIMD isn't supported
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "cpu.c"
+
+#define SORTNET_MAX			64		/*the max key count of sorting network*/
+#define SORTNET_THRESHOLD	32		/*the quick sort uses sorting network below this count*/
+
+/*
+ * generate the odd-even merge sorting network of an array, the comparators
+ * beyond uCount are skipped as if the array is padded by max keys
+ * @param Name -- the name of generated function, it is void Name(TYPE *pBase, UINT uCount)
+ * @param TYPE -- the element type of array
+ * @param LESS -- the macro LESS(a, b) returns nonzero if a is less than b
+ */
+#define SORTNET_DEFINE(Name, TYPE, LESS)												\
+static void Name(TYPE *pBase, UINT uCount)												\
+{																						\
+	UINT p, k, i, j;																	\
+	TYPE Data1;																			\
+	TYPE Data2;																			\
+	INT bLess;																			\
+	for (p = 1; p < uCount; p <<= 1)													\
+	{																					\
+		for (k = p; k > 0; k >>= 1)														\
+		{																				\
+			for (j = k % p; j + k < uCount; j += 2 * k)									\
+			{																			\
+				for (i = j; i < j + k && i + k < uCount; ++i)							\
+				{																		\
+					if ((i ^ (i + k)) >= 2 * p)											\
+					{																	\
+						continue;														\
+					}																	\
+					Data1 = pBase[i];													\
+					Data2 = pBase[i + k];												\
+					bLess = LESS(Data2, Data1);											\
+					pBase[i] = bLess ? Data2 : Data1;									\
+					pBase[i + k] = bLess ? Data1 : Data2;								\
+				}																		\
+			}																			\
+		}																				\
+	}																					\
+}
+
+#define SORTNET_LESS(a, b)	((a) < (b))
+
+SORTNET_DEFINE(SortNet_Int32Scalar, INT32, SORTNET_LESS)
+SORTNET_DEFINE(SortNet_Int64Scalar, INT64, SORTNET_LESS)
+
+#if defined(CPU_X86)
+/*
+ * the bitonic network of uSize keys, uSize is power of 2 and not less than the
+ * width of register. The pairs of distance j are compared in register by shuffle
+ * when j is less than the width, or else two registers are compared
+ */
+static CPU_TARGET_SSE41 void SortNet_Int32Sse41(INT32 *pKey, UINT uSize)
+{
+	__m128i Lane = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i Data1, Data2, Min, Max, Index, Bit, Dir;
+	UINT i, j, k;
+	for (k = 2; k <= uSize; k <<= 1)
+	{
+		for (j = k >> 1; j > 0; j >>= 1)
+		{
+			if (j >= 4)
+			{
+				for (i = 0; i < uSize; i += 4)
+				{
+					if (i & j)
+					{
+						continue;
+					}
+					Data1 = _mm_loadu_si128((const __m128i *)(pKey + i));
+					Data2 = _mm_loadu_si128((const __m128i *)(pKey + i + j));
+					Min = _mm_min_epi32(Data1, Data2);
+					Max = _mm_max_epi32(Data1, Data2);
+					/*the blocks of k keys are sorted in descending order alternately*/
+					_mm_storeu_si128((__m128i *)(pKey + i), (i & k) ? Max : Min);
+					_mm_storeu_si128((__m128i *)(pKey + i + j), (i & k) ? Min : Max);
+				}
+				continue;
+			}
+			for (i = 0; i < uSize; i += 4)
+			{
+				Data1 = _mm_loadu_si128((const __m128i *)(pKey + i));
+				Data2 = (2 == j) ? _mm_shuffle_epi32(Data1, 0x4E) : _mm_shuffle_epi32(Data1, 0xB1);
+				Min = _mm_min_epi32(Data1, Data2);
+				Max = _mm_max_epi32(Data1, Data2);
+				/*the upper key of pair takes max in ascending block, and min in descending block*/
+				Index = _mm_add_epi32(_mm_set1_epi32((int)i), Lane);
+				Bit = _mm_set1_epi32((int)j);
+				Dir = _mm_set1_epi32((int)k);
+				Bit = _mm_cmpeq_epi32(_mm_and_si128(Index, Bit), Bit);
+				Dir = _mm_cmpeq_epi32(_mm_and_si128(Index, Dir), Dir);
+				_mm_storeu_si128((__m128i *)(pKey + i),
+					_mm_blendv_epi8(Min, Max, _mm_xor_si128(Bit, Dir)));
+			}
+		}
+	}
+}
+
+static CPU_TARGET_AVX2 void SortNet_Int32Avx2(INT32 *pKey, UINT uSize)
+{
+	__m256i Lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i Data1, Data2, Min, Max, Index, Bit, Dir;
+	UINT i, j, k;
+	for (k = 2; k <= uSize; k <<= 1)
+	{
+		for (j = k >> 1; j > 0; j >>= 1)
+		{
+			if (j >= 8)
+			{
+				for (i = 0; i < uSize; i += 8)
+				{
+					if (i & j)
+					{
+						continue;
+					}
+					Data1 = _mm256_loadu_si256((const __m256i *)(pKey + i));
+					Data2 = _mm256_loadu_si256((const __m256i *)(pKey + i + j));
+					Min = _mm256_min_epi32(Data1, Data2);
+					Max = _mm256_max_epi32(Data1, Data2);
+					_mm256_storeu_si256((__m256i *)(pKey + i), (i & k) ? Max : Min);
+					_mm256_storeu_si256((__m256i *)(pKey + i + j), (i & k) ? Min : Max);
+				}
+				continue;
+			}
+			Bit = _mm256_set1_epi32((int)j);
+			Dir = _mm256_set1_epi32((int)k);
+			for (i = 0; i < uSize; i += 8)
+			{
+				Data1 = _mm256_loadu_si256((const __m256i *)(pKey + i));
+				Data2 = _mm256_permutevar8x32_epi32(Data1, _mm256_xor_si256(Lane, Bit));
+				Min = _mm256_min_epi32(Data1, Data2);
+				Max = _mm256_max_epi32(Data1, Data2);
+				Index = _mm256_add_epi32(_mm256_set1_epi32((int)i), Lane);
+				_mm256_storeu_si256((__m256i *)(pKey + i), _mm256_blendv_epi8(Min, Max,
+					_mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(Index, Bit), Bit),
+						_mm256_cmpeq_epi32(_mm256_and_si256(Index, Dir), Dir))));
+			}
+		}
+	}
+}
+
+/*
+ * the bitonic network of INT64 keys, the min and max are selected by the mask of
+ * 64-bit comparison since there are no such instructions
+ */
+static CPU_TARGET_SSE42 void SortNet_Int64Sse42(INT64 *pKey, UINT uSize)
+{
+	__m128i Lane = _mm_set_epi64x(1, 0);
+	__m128i Data1, Data2, Greater, Min, Max, Index, Bit, Dir;
+	UINT i, j, k;
+	for (k = 2; k <= uSize; k <<= 1)
+	{
+		for (j = k >> 1; j > 0; j >>= 1)
+		{
+			for (i = 0; i < uSize; i += 2)
+			{
+				if (j >= 2)
+				{
+					if (i & j)
+					{
+						continue;
+					}
+					Data1 = _mm_loadu_si128((const __m128i *)(pKey + i));
+					Data2 = _mm_loadu_si128((const __m128i *)(pKey + i + j));
+					Greater = _mm_cmpgt_epi64(Data1, Data2);
+					Min = _mm_blendv_epi8(Data1, Data2, Greater);
+					Max = _mm_blendv_epi8(Data2, Data1, Greater);
+					_mm_storeu_si128((__m128i *)(pKey + i), (i & k) ? Max : Min);
+					_mm_storeu_si128((__m128i *)(pKey + i + j), (i & k) ? Min : Max);
+					continue;
+				}
+				Data1 = _mm_loadu_si128((const __m128i *)(pKey + i));
+				Data2 = _mm_shuffle_epi32(Data1, 0x4E);
+				Greater = _mm_cmpgt_epi64(Data1, Data2);
+				Min = _mm_blendv_epi8(Data1, Data2, Greater);
+				Max = _mm_blendv_epi8(Data2, Data1, Greater);
+				Index = _mm_add_epi64(_mm_set1_epi64x((INT64)i), Lane);
+				Bit = _mm_set1_epi64x((INT64)j);
+				Dir = _mm_set1_epi64x((INT64)k);
+				Bit = _mm_cmpeq_epi64(_mm_and_si128(Index, Bit), Bit);
+				Dir = _mm_cmpeq_epi64(_mm_and_si128(Index, Dir), Dir);
+				_mm_storeu_si128((__m128i *)(pKey + i),
+					_mm_blendv_epi8(Min, Max, _mm_xor_si128(Bit, Dir)));
+			}
+		}
+	}
+}
+
+static CPU_TARGET_AVX2 void SortNet_Int64Avx2(INT64 *pKey, UINT uSize)
+{
+	__m256i Lane = _mm256_setr_epi64x(0, 1, 2, 3);
+	__m256i Data1, Data2, Greater, Min, Max, Index, Bit, Dir;
+	UINT i, j, k;
+	for (k = 2; k <= uSize; k <<= 1)
+	{
+		for (j = k >> 1; j > 0; j >>= 1)
+		{
+			for (i = 0; i < uSize; i += 4)
+			{
+				if (j >= 4)
+				{
+					if (i & j)
+					{
+						continue;
+					}
+					Data1 = _mm256_loadu_si256((const __m256i *)(pKey + i));
+					Data2 = _mm256_loadu_si256((const __m256i *)(pKey + i + j));
+					Greater = _mm256_cmpgt_epi64(Data1, Data2);
+					Min = _mm256_blendv_epi8(Data1, Data2, Greater);
+					Max = _mm256_blendv_epi8(Data2, Data1, Greater);
+					_mm256_storeu_si256((__m256i *)(pKey + i), (i & k) ? Max : Min);
+					_mm256_storeu_si256((__m256i *)(pKey + i + j), (i & k) ? Min : Max);
+					continue;
+				}
+				Data1 = _mm256_loadu_si256((const __m256i *)(pKey + i));
+				Data2 = (2 == j) ? _mm256_permute4x64_epi64(Data1, 0x4E) : _mm256_permute4x64_epi64(Data1, 0xB1);
+				Greater = _mm256_cmpgt_epi64(Data1, Data2);
+				Min = _mm256_blendv_epi8(Data1, Data2, Greater);
+				Max = _mm256_blendv_epi8(Data2, Data1, Greater);
+				Index = _mm256_add_epi64(_mm256_set1_epi64x((INT64)i), Lane);
+				Bit = _mm256_set1_epi64x((INT64)j);
+				Dir = _mm256_set1_epi64x((INT64)k);
+				Bit = _mm256_cmpeq_epi64(_mm256_and_si256(Index, Bit), Bit);
+				Dir = _mm256_cmpeq_epi64(_mm256_and_si256(Index, Dir), Dir);
+				_mm256_storeu_si256((__m256i *)(pKey + i),
+					_mm256_blendv_epi8(Min, Max, _mm256_xor_si256(Bit, Dir)));
+			}
+		}
+	}
+}
+#endif
+
+/*
+ * sort a small array of INT32 by sorting network
+ * @param INT32 *pBase
+ * @param UINT uCount -- it must not be more than SORTNET_MAX
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if uCount is too large
+ */
+INT SortNet_Int32(INT32 *pBase, UINT uCount)
+{
+#if defined(CPU_X86)
+	INT32 anKey[SORTNET_MAX];
+	UINT uFeatures;
+	UINT uSize;
+	UINT i;
+#endif
+	if (NULL == pBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	if (uCount < 2)
+	{
+		return CAPI_SUCCESS;
+	}
+#if defined(CPU_X86)
+	uFeatures = Cpu_GetFeatures();
+	if (uFeatures & (CPU_FEATURE_AVX2 | CPU_FEATURE_SSE41))
+	{
+		/*the bitonic network needs the power of 2 keys, pad them by max key*/
+		uSize = 8;
+		while (uSize < uCount)
+		{
+			uSize <<= 1;
+		}
+		memcpy(anKey, pBase, uCount * sizeof(INT32));
+		for (i = uCount; i < uSize; ++i)
+		{
+			anKey[i] = 0x7FFFFFFF;
+		}
+		if (uFeatures & CPU_FEATURE_AVX2)
+		{
+			SortNet_Int32Avx2(anKey, uSize);
+		}
+		else
+		{
+			SortNet_Int32Sse41(anKey, uSize);
+		}
+		memcpy(pBase, anKey, uCount * sizeof(INT32));
+		return CAPI_SUCCESS;
+	}
+#endif
+	SortNet_Int32Scalar(pBase, uCount);
+	return CAPI_SUCCESS;
+}
+
+/*
+ * sort a small array of INT64 by sorting network
+ * @param INT64 *pBase
+ * @param UINT uCount -- it must not be more than SORTNET_MAX
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if uCount is too large
+ */
+INT SortNet_Int64(INT64 *pBase, UINT uCount)
+{
+#if defined(CPU_X86)
+	INT64 anKey[SORTNET_MAX];
+	UINT uFeatures;
+	UINT uSize;
+	UINT i;
+#endif
+	if (NULL == pBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	if (uCount < 2)
+	{
+		return CAPI_SUCCESS;
+	}
+#if defined(CPU_X86)
+	uFeatures = Cpu_GetFeatures();
+	if (uFeatures & (CPU_FEATURE_AVX2 | CPU_FEATURE_SSE42))
+	{
+		uSize = 4;
+		while (uSize < uCount)
+		{
+			uSize <<= 1;
+		}
+		memcpy(anKey, pBase, uCount * sizeof(INT64));
+		for (i = uCount; i < uSize; ++i)
+		{
+			anKey[i] = (INT64)0x7FFFFFFFFFFFFFFFULL;
+		}
+		if (uFeatures & CPU_FEATURE_AVX2)
+		{
+			SortNet_Int64Avx2(anKey, uSize);
+		}
+		else
+		{
+			SortNet_Int64Sse42(anKey, uSize);
+		}
+		memcpy(pBase, anKey, uCount * sizeof(INT64));
+		return CAPI_SUCCESS;
+	}
+#endif
+	SortNet_Int64Scalar(pBase, uCount);
+	return CAPI_SUCCESS;
+}
+
+/*
+ * sort a small array of UINT32 by sorting network, the keys are xor-ed with the
+ * sign bit so that they can be sorted as signed
+ * @param UINT32 *pBase
+ * @param UINT uCount -- it must not be more than SORTNET_MAX
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if uCount is too large
+ */
+INT SortNet_UInt32(UINT32 *pBase, UINT uCount)
+{
+	UINT i;
+	INT nRet;
+	if (NULL == pBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		pBase[i] ^= 0x80000000U;
+	}
+	nRet = SortNet_Int32((INT32 *)pBase, uCount);
+	for (i = 0; i < uCount; ++i)
+	{
+		pBase[i] ^= 0x80000000U;
+	}
+	return nRet;
+}
+
+/*
+ * sort a small array of float by sorting network, the bits of negative float
+ * except the sign bit are flipped so that they can be sorted as signed integer.
+ * -0.0 is less than 0.0, and NaN is less or greater than all numbers by its sign
+ * @param float *pBase
+ * @param UINT uCount -- it must not be more than SORTNET_MAX
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if uCount is too large
+ */
+INT SortNet_Float(float *pBase, UINT uCount)
+{
+	INT32 anKey[SORTNET_MAX];
+	UINT i;
+	if (NULL == pBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	memcpy(anKey, pBase, uCount * sizeof(INT32));
+	for (i = 0; i < uCount; ++i)
+	{
+		anKey[i] ^= (anKey[i] >> 31) & 0x7FFFFFFF;
+	}
+	(void)SortNet_Int32(anKey, uCount);
+	for (i = 0; i < uCount; ++i)
+	{
+		anKey[i] ^= (anKey[i] >> 31) & 0x7FFFFFFF;
+	}
+	memcpy(pBase, anKey, uCount * sizeof(INT32));
+	return CAPI_SUCCESS;
+}
+
+/*
+ * sort a small pointer array by the unsigned 32-bit keys, each key is packed
+ * with the index of its pointer so that the pointers are moved by the sorted
+ * 64-bit keys
+ * @param void **ppBase
+ * @param INT64 *pKey -- the keys in the high 32 bits, they are sorted in place
+ * @param UINT uCount -- it must not be more than SORTNET_MAX
+ * @return void
+ */
+static void SortNet_SortPtr(void **ppBase, INT64 *pKey, UINT uCount)
+{
+	void *apData[SORTNET_MAX];
+	UINT i;
+	for (i = 0; i < uCount; ++i)
+	{
+		pKey[i] ^= (INT64)((UINT64)1 << 63) | (INT64)i;
+	}
+	(void)SortNet_Int64(pKey, uCount);
+	memcpy(apData, ppBase, uCount * sizeof(void *));
+	for (i = 0; i < uCount; ++i)
+	{
+		ppBase[i] = apData[(UINT32)pKey[i]];
+	}
+}
+
+/*
+ * sort a small pointer array whose data is the key, for example:
+ * INT SortNet_PtrInt32(void **ppBase, UINT uCount), uCount must not be more
+ * than SORTNET_MAX
+ */
+INT SortNet_PtrInt32(void **ppBase, UINT uCount)
+{
+	INT64 anKey[SORTNET_MAX];
+	UINT i;
+	if (NULL == ppBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		anKey[i] = (INT64)((UINT64)(*(UINT32 *)ppBase[i] ^ 0x80000000U) << 32);
+	}
+	SortNet_SortPtr(ppBase, anKey, uCount);
+	return CAPI_SUCCESS;
+}
+
+INT SortNet_PtrUInt32(void **ppBase, UINT uCount)
+{
+	INT64 anKey[SORTNET_MAX];
+	UINT i;
+	if (NULL == ppBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		anKey[i] = (INT64)((UINT64)*(UINT32 *)ppBase[i] << 32);
+	}
+	SortNet_SortPtr(ppBase, anKey, uCount);
+	return CAPI_SUCCESS;
+}
+
+INT SortNet_PtrFloat(void **ppBase, UINT uCount)
+{
+	INT64 anKey[SORTNET_MAX];
+	UINT32 uKey;
+	UINT i;
+	if (NULL == ppBase || uCount > SORTNET_MAX)
+	{
+		return CAPI_FAILED;
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		memcpy(&uKey, ppBase[i], sizeof(uKey));
+		/*flip all bits of negative number and only the sign bit of positive number*/
+		uKey ^= (UINT32)(0 - (uKey >> 31)) | 0x80000000U;
+		anKey[i] = (INT64)((UINT64)uKey << 32);
+	}
+	SortNet_SortPtr(ppBase, anKey, uCount);
+	return CAPI_SUCCESS;
+}
@@ -0,0 +1,682 @@
+/*********************************************************************************
+ * FileName:	stableSort.c
+ * Author:		gehan
+ * Date:		07/10/2017
+ * Description: Adaptive stable sort (TimSort) of sort table, it detects the natural
+ *				runs, extends short runs by binary insertion sort and merges the
+ *				runs with galloping mode
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "quickSort.c"
+
+/* the run shorter than this value will be extended by binary insertion sort */
+#define STABLESORT_MIN_MERGE		32
+
+/* the initial threshold to enter galloping mode */
+#define STABLESORT_MIN_GALLOP		7
+
+/* the max count of pending runs, it is enough for 2^64 data */
+#define STABLESORT_MAX_RUNS			85
+
+/*
+ * the state of stable sort
+ */
+typedef struct STABLESORT_st {
+	SORTTABLE *pTable;			/*the sort table whose stats are counted*/
+	void **ppBase;				/*the first data to sort*/
+	COMPAREFUNC CompareFunc;
+	void **ppTemp;				/*the buffer of merge, its size is half of data*/
+	INT nMinGallop;				/*the current threshold to enter galloping mode*/
+	INT nRunCount;
+	INT anRunBase[STABLESORT_MAX_RUNS];
+	INT anRunLen[STABLESORT_MAX_RUNS];
+}STABLESORT;
+
+/*
+ * sort [nLow, nHigh) by binary insertion sort, [nLow, nStart) is already sorted
+ * @param STABLESORT *pSort
+ * @param INT nLow
+ * @param INT nHigh
+ * @param INT nStart
+ * @return void
+ */
+static void StableSort_BinaryInsertSort(STABLESORT *pSort, INT nLow, INT nHigh, INT nStart)
+{
+	void **ppBase = pSort->ppBase;
+	INT nLeft, nRight, nMid;
+	void *pData;
+	for (; nStart < nHigh; ++nStart)
+	{
+		pData = ppBase[nStart];
+		nLeft = nLow;
+		nRight = nStart;
+		/*find the position after all equal data to keep stable*/
+		while (nLeft < nRight)
+		{
+			nMid = nLeft + (nRight - nLeft) / 2;
+			if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pData, ppBase[nMid]) < 0)
+			{
+				nRight = nMid;
+			}
+			else
+			{
+				nLeft = nMid + 1;
+			}
+		}
+		memmove(&ppBase[nLeft + 1], &ppBase[nLeft], (nStart - nLeft) * sizeof(void *));
+		ppBase[nLeft] = pData;
+		SORTSTATS_MOVE(pSort->pTable, nStart - nLeft + 1);
+	}
+}
+
+/*
+ * get the length of the run beginning at nLow, and reverse it if it is
+ * strictly descending (strictly so that the reverse keeps stable)
+ * @param STABLESORT *pSort
+ * @param INT nLow
+ * @param INT nHigh
+ * @return INT -- the length of run
+ */
+static INT StableSort_CountRun(STABLESORT *pSort, INT nLow, INT nHigh)
+{
+	void **ppBase = pSort->ppBase;
+	INT nRunHigh = nLow + 1;
+	INT i, j;
+	void *pData;
+	if (nRunHigh == nHigh)
+	{
+		return 1;
+	}
+	if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, ppBase[nRunHigh], ppBase[nLow]) < 0)
+	{
+		++nRunHigh;
+		while (nRunHigh < nHigh && SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, ppBase[nRunHigh], ppBase[nRunHigh - 1]) < 0)
+		{
+			++nRunHigh;
+		}
+		for (i = nLow, j = nRunHigh - 1; i < j; ++i, --j)
+		{
+			pData = ppBase[i];
+			ppBase[i] = ppBase[j];
+			ppBase[j] = pData;
+			SORTSTATS_MOVE(pSort->pTable, 2);
+		}
+	}
+	else
+	{
+		++nRunHigh;
+		while (nRunHigh < nHigh && SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, ppBase[nRunHigh], ppBase[nRunHigh - 1]) >= 0)
+		{
+			++nRunHigh;
+		}
+	}
+	return nRunHigh - nLow;
+}
+
+/*
+ * get the min run length, it makes the count of runs is equal to or a
+ * little less than a power of 2
+ * @param INT nCount
+ * @return INT
+ */
+static INT StableSort_MinRun(INT nCount)
+{
+	INT nBit = 0;
+	while (nCount >= STABLESORT_MIN_MERGE)
+	{
+		nBit |= nCount & 1;
+		nCount >>= 1;
+	}
+	return nCount + nBit;
+}
+
+/*
+ * find the position to insert pKey into sorted array, it is before all equal data
+ * @param STABLESORT *pSort
+ * @param void *pKey
+ * @param void **ppArray
+ * @param INT nLen
+ * @param INT nHint -- the position to begin search
+ * @return INT -- ppArray[ret-1] < pKey <= ppArray[ret]
+ */
+static INT StableSort_GallopLeft(STABLESORT *pSort, void *pKey, void **ppArray, INT nLen, INT nHint)
+{
+	INT nLastOfs = 0;
+	INT nOfs = 1;
+	INT nMaxOfs, nMid, nTemp;
+	if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nHint]) > 0)
+	{
+		/*gallop right until ppArray[nHint+nLastOfs] < pKey <= ppArray[nHint+nOfs]*/
+		nMaxOfs = nLen - nHint;
+		while (nOfs < nMaxOfs && SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nHint + nOfs]) > 0)
+		{
+			nLastOfs = nOfs;
+			nOfs = (nOfs << 1) + 1;
+			if (nOfs <= 0)
+			{
+				nOfs = nMaxOfs;
+			}
+		}
+		if (nOfs > nMaxOfs)
+		{
+			nOfs = nMaxOfs;
+		}
+		nLastOfs += nHint;
+		nOfs += nHint;
+	}
+	else
+	{
+		/*gallop left until ppArray[nHint-nOfs] < pKey <= ppArray[nHint-nLastOfs]*/
+		nMaxOfs = nHint + 1;
+		while (nOfs < nMaxOfs && SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nHint - nOfs]) <= 0)
+		{
+			nLastOfs = nOfs;
+			nOfs = (nOfs << 1) + 1;
+			if (nOfs <= 0)
+			{
+				nOfs = nMaxOfs;
+			}
+		}
+		if (nOfs > nMaxOfs)
+		{
+			nOfs = nMaxOfs;
+		}
+		nTemp = nLastOfs;
+		nLastOfs = nHint - nOfs;
+		nOfs = nHint - nTemp;
+	}
+	/*binary search in (nLastOfs, nOfs]*/
+	++nLastOfs;
+	while (nLastOfs < nOfs)
+	{
+		nMid = nLastOfs + (nOfs - nLastOfs) / 2;
+		if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nMid]) > 0)
+		{
+			nLastOfs = nMid + 1;
+		}
+		else
+		{
+			nOfs = nMid;
+		}
+	}
+	return nOfs;
+}
+
+/*
+ * find the position to insert pKey into sorted array, it is after all equal data
+ * @param STABLESORT *pSort
+ * @param void *pKey
+ * @param void **ppArray
+ * @param INT nLen
+ * @param INT nHint -- the position to begin search
+ * @return INT -- ppArray[ret-1] <= pKey < ppArray[ret]
+ */
+static INT StableSort_GallopRight(STABLESORT *pSort, void *pKey, void **ppArray, INT nLen, INT nHint)
+{
+	INT nLastOfs = 0;
+	INT nOfs = 1;
+	INT nMaxOfs, nMid, nTemp;
+	if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nHint]) < 0)
+	{
+		/*gallop left until ppArray[nHint-nOfs] <= pKey < ppArray[nHint-nLastOfs]*/
+		nMaxOfs = nHint + 1;
+		while (nOfs < nMaxOfs && SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nHint - nOfs]) < 0)
+		{
+			nLastOfs = nOfs;
+			nOfs = (nOfs << 1) + 1;
+			if (nOfs <= 0)
+			{
+				nOfs = nMaxOfs;
+			}
+		}
+		if (nOfs > nMaxOfs)
+		{
+			nOfs = nMaxOfs;
+		}
+		nTemp = nLastOfs;
+		nLastOfs = nHint - nOfs;
+		nOfs = nHint - nTemp;
+	}
+	else
+	{
+		/*gallop right until ppArray[nHint+nLastOfs] <= pKey < ppArray[nHint+nOfs]*/
+		nMaxOfs = nLen - nHint;
+		while (nOfs < nMaxOfs && SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nHint + nOfs]) >= 0)
+		{
+			nLastOfs = nOfs;
+			nOfs = (nOfs << 1) + 1;
+			if (nOfs <= 0)
+			{
+				nOfs = nMaxOfs;
+			}
+		}
+		if (nOfs > nMaxOfs)
+		{
+			nOfs = nMaxOfs;
+		}
+		nLastOfs += nHint;
+		nOfs += nHint;
+	}
+	/*binary search in (nLastOfs, nOfs]*/
+	++nLastOfs;
+	while (nLastOfs < nOfs)
+	{
+		nMid = nLastOfs + (nOfs - nLastOfs) / 2;
+		if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, pKey, ppArray[nMid]) < 0)
+		{
+			nOfs = nMid;
+		}
+		else
+		{
+			nLastOfs = nMid + 1;
+		}
+	}
+	return nOfs;
+}
+
+/*
+ * merge two adjacent runs from left to right, the first run is shorter and
+ * ppBase[nBase1] > ppBase[nBase2] and the last data of first run is greater
+ * than all data in second run
+ * @param STABLESORT *pSort
+ * @param INT nBase1
+ * @param INT nLen1
+ * @param INT nBase2
+ * @param INT nLen2
+ * @return void
+ */
+static void StableSort_MergeLo(STABLESORT *pSort, INT nBase1, INT nLen1, INT nBase2, INT nLen2)
+{
+	void **ppBase = pSort->ppBase;
+	void **ppTemp = pSort->ppTemp;
+	INT nCursor1 = 0;			/*index in ppTemp*/
+	INT nCursor2 = nBase2;
+	INT nDest = nBase1;
+	INT nMinGallop = pSort->nMinGallop;
+	INT nCount1, nCount2;
+
+	memcpy(ppTemp, &ppBase[nBase1], nLen1 * sizeof(void *));
+	ppBase[nDest++] = ppBase[nCursor2++];
+	if (0 == --nLen2)
+	{
+		memcpy(&ppBase[nDest], &ppTemp[nCursor1], nLen1 * sizeof(void *));
+		return;
+	}
+	if (1 == nLen1)
+	{
+		memmove(&ppBase[nDest], &ppBase[nCursor2], nLen2 * sizeof(void *));
+		ppBase[nDest + nLen2] = ppTemp[nCursor1];
+		return;
+	}
+
+	for (;;)
+	{
+		nCount1 = 0;	/*the count of times the first run won in a row*/
+		nCount2 = 0;	/*the count of times the second run won in a row*/
+		/*merge one pair at a time until one run wins consistently*/
+		do
+		{
+			if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, ppBase[nCursor2], ppTemp[nCursor1]) < 0)
+			{
+				ppBase[nDest++] = ppBase[nCursor2++];
+				++nCount2;
+				nCount1 = 0;
+				if (0 == --nLen2)
+				{
+					goto END;
+				}
+			}
+			else
+			{
+				ppBase[nDest++] = ppTemp[nCursor1++];
+				++nCount1;
+				nCount2 = 0;
+				if (1 == --nLen1)
+				{
+					goto END;
+				}
+			}
+		} while ((nCount1 | nCount2) < nMinGallop);
+
+		/*galloping mode, until neither run wins consistently*/
+		do
+		{
+			nCount1 = StableSort_GallopRight(pSort, ppBase[nCursor2], &ppTemp[nCursor1], nLen1, 0);
+			if (0 != nCount1)
+			{
+				memcpy(&ppBase[nDest], &ppTemp[nCursor1], nCount1 * sizeof(void *));
+				nDest += nCount1;
+				nCursor1 += nCount1;
+				nLen1 -= nCount1;
+				if (nLen1 <= 1)
+				{
+					goto END;
+				}
+			}
+			ppBase[nDest++] = ppBase[nCursor2++];
+			if (0 == --nLen2)
+			{
+				goto END;
+			}
+
+			nCount2 = StableSort_GallopLeft(pSort, ppTemp[nCursor1], &ppBase[nCursor2], nLen2, 0);
+			if (0 != nCount2)
+			{
+				memmove(&ppBase[nDest], &ppBase[nCursor2], nCount2 * sizeof(void *));
+				nDest += nCount2;
+				nCursor2 += nCount2;
+				nLen2 -= nCount2;
+				if (0 == nLen2)
+				{
+					goto END;
+				}
+			}
+			ppBase[nDest++] = ppTemp[nCursor1++];
+			if (1 == --nLen1)
+			{
+				goto END;
+			}
+			--nMinGallop;
+		} while (nCount1 >= STABLESORT_MIN_GALLOP || nCount2 >= STABLESORT_MIN_GALLOP);
+		if (nMinGallop < 0)
+		{
+			nMinGallop = 0;
+		}
+		/*penalize for leaving galloping mode*/
+		nMinGallop += 2;
+	}
+
+END:
+	pSort->nMinGallop = nMinGallop < 1 ? 1 : nMinGallop;
+	if (1 == nLen1)
+	{
+		memmove(&ppBase[nDest], &ppBase[nCursor2], nLen2 * sizeof(void *));
+		ppBase[nDest + nLen2] = ppTemp[nCursor1];
+	}
+	else
+	{
+		memcpy(&ppBase[nDest], &ppTemp[nCursor1], nLen1 * sizeof(void *));
+	}
+}
+
+/*
+ * merge two adjacent runs from right to left, the second run is shorter and
+ * ppBase[nBase1] > ppBase[nBase2] and the last data of first run is greater
+ * than all data in second run
+ * @param STABLESORT *pSort
+ * @param INT nBase1
+ * @param INT nLen1
+ * @param INT nBase2
+ * @param INT nLen2
+ * @return void
+ */
+static void StableSort_MergeHi(STABLESORT *pSort, INT nBase1, INT nLen1, INT nBase2, INT nLen2)
+{
+	void **ppBase = pSort->ppBase;
+	void **ppTemp = pSort->ppTemp;
+	INT nCursor1 = nBase1 + nLen1 - 1;
+	INT nCursor2 = nLen2 - 1;	/*index in ppTemp*/
+	INT nDest = nBase2 + nLen2 - 1;
+	INT nMinGallop = pSort->nMinGallop;
+	INT nCount1, nCount2;
+
+	memcpy(ppTemp, &ppBase[nBase2], nLen2 * sizeof(void *));
+	ppBase[nDest--] = ppBase[nCursor1--];
+	if (0 == --nLen1)
+	{
+		memcpy(&ppBase[nDest - (nLen2 - 1)], ppTemp, nLen2 * sizeof(void *));
+		return;
+	}
+	if (1 == nLen2)
+	{
+		nDest -= nLen1;
+		nCursor1 -= nLen1;
+		memmove(&ppBase[nDest + 1], &ppBase[nCursor1 + 1], nLen1 * sizeof(void *));
+		ppBase[nDest] = ppTemp[nCursor2];
+		return;
+	}
+
+	for (;;)
+	{
+		nCount1 = 0;
+		nCount2 = 0;
+		do
+		{
+			if (SORTTABLE_COMPARE(pSort->pTable, pSort->CompareFunc, ppTemp[nCursor2], ppBase[nCursor1]) < 0)
+			{
+				ppBase[nDest--] = ppBase[nCursor1--];
+				++nCount1;
+				nCount2 = 0;
+				if (0 == --nLen1)
+				{
+					goto END;
+				}
+			}
+			else
+			{
+				ppBase[nDest--] = ppTemp[nCursor2--];
+				++nCount2;
+				nCount1 = 0;
+				if (1 == --nLen2)
+				{
+					goto END;
+				}
+			}
+		} while ((nCount1 | nCount2) < nMinGallop);
+
+		do
+		{
+			nCount1 = nLen1 - StableSort_GallopRight(pSort, ppTemp[nCursor2], &ppBase[nBase1], nLen1, nLen1 - 1);
+			if (0 != nCount1)
+			{
+				nDest -= nCount1;
+				nCursor1 -= nCount1;
+				nLen1 -= nCount1;
+				memmove(&ppBase[nDest + 1], &ppBase[nCursor1 + 1], nCount1 * sizeof(void *));
+				if (0 == nLen1)
+				{
+					goto END;
+				}
+			}
+			ppBase[nDest--] = ppTemp[nCursor2--];
+			if (1 == --nLen2)
+			{
+				goto END;
+			}
+
+			nCount2 = nLen2 - StableSort_GallopLeft(pSort, ppBase[nCursor1], ppTemp, nLen2, nLen2 - 1);
+			if (0 != nCount2)
+			{
+				nDest -= nCount2;
+				nCursor2 -= nCount2;
+				nLen2 -= nCount2;
+				memcpy(&ppBase[nDest + 1], &ppTemp[nCursor2 + 1], nCount2 * sizeof(void *));
+				if (nLen2 <= 1)
+				{
+					goto END;
+				}
+			}
+			ppBase[nDest--] = ppBase[nCursor1--];
+			if (0 == --nLen1)
+			{
+				goto END;
+			}
+			--nMinGallop;
+		} while (nCount1 >= STABLESORT_MIN_GALLOP || nCount2 >= STABLESORT_MIN_GALLOP);
+		if (nMinGallop < 0)
+		{
+			nMinGallop = 0;
+		}
+		nMinGallop += 2;
+	}
+
+END:
+	pSort->nMinGallop = nMinGallop < 1 ? 1 : nMinGallop;
+	if (1 == nLen2)
+	{
+		nDest -= nLen1;
+		nCursor1 -= nLen1;
+		memmove(&ppBase[nDest + 1], &ppBase[nCursor1 + 1], nLen1 * sizeof(void *));
+		ppBase[nDest] = ppTemp[nCursor2];
+	}
+	else
+	{
+		memcpy(&ppBase[nDest - (nLen2 - 1)], ppTemp, nLen2 * sizeof(void *));
+	}
+}
+
+/*
+ * merge the ith and (i+1)th runs in the run stack
+ * @param STABLESORT *pSort
+ * @param INT i
+ * @return void
+ */
+static void StableSort_MergeAt(STABLESORT *pSort, INT i)
+{
+	INT nBase1 = pSort->anRunBase[i];
+	INT nLen1 = pSort->anRunLen[i];
+	INT nBase2 = pSort->anRunBase[i + 1];
+	INT nLen2 = pSort->anRunLen[i + 1];
+	INT k;
+
+	pSort->anRunLen[i] = nLen1 + nLen2;
+	if (i == pSort->nRunCount - 3)
+	{
+		pSort->anRunBase[i + 1] = pSort->anRunBase[i + 2];
+		pSort->anRunLen[i + 1] = pSort->anRunLen[i + 2];
+	}
+	--pSort->nRunCount;
+
+	/*the data of first run before the first data of second run is in place*/
+	k = StableSort_GallopRight(pSort, pSort->ppBase[nBase2], &pSort->ppBase[nBase1], nLen1, 0);
+	nBase1 += k;
+	nLen1 -= k;
+	if (0 == nLen1)
+	{
+		return;
+	}
+	/*the data of second run after the last data of first run is in place*/
+	nLen2 = StableSort_GallopLeft(pSort, pSort->ppBase[nBase1 + nLen1 - 1], &pSort->ppBase[nBase2], nLen2, nLen2 - 1);
+	if (0 == nLen2)
+	{
+		return;
+	}
+	/*the shorter run is copied to buffer, then all data of both runs are written once*/
+	SORTSTATS_MOVE(pSort->pTable, (nLen1 <= nLen2 ? nLen1 : nLen2) + nLen1 + nLen2);
+	if (nLen1 <= nLen2)
+	{
+		StableSort_MergeLo(pSort, nBase1, nLen1, nBase2, nLen2);
+	}
+	else
+	{
+		StableSort_MergeHi(pSort, nBase1, nLen1, nBase2, nLen2);
+	}
+}
+
+/*
+ * merge the runs until the run stack satisfies the invariants:
+ * len[i-2] > len[i-1] + len[i] and len[i-1] > len[i]
+ * @param STABLESORT *pSort
+ * @return void
+ */
+static void StableSort_MergeCollapse(STABLESORT *pSort)
+{
+	INT *pnLen = pSort->anRunLen;
+	INT n;
+	while (pSort->nRunCount > 1)
+	{
+		n = pSort->nRunCount - 2;
+		if ((n > 0 && pnLen[n - 1] <= pnLen[n] + pnLen[n + 1])
+			|| (n > 1 && pnLen[n - 2] <= pnLen[n - 1] + pnLen[n]))
+		{
+			if (pnLen[n - 1] < pnLen[n + 1])
+			{
+				--n;
+			}
+		}
+		else if (pnLen[n] > pnLen[n + 1])
+		{
+			break;
+		}
+		StableSort_MergeAt(pSort, n);
+	}
+}
+
+/*
+ * the adaptive stable sort of sort table, it is close to O(n) for nearly sorted
+ * data and O(nlogn) in the worst case, the equal data keeps its original order
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @param COMPAREFUNC CompareFunc -- the comparison function
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT SortTable_StableSort(SORTTABLE *pTable, UINT uStart, UINT uEnd, COMPAREFUNC CompareFunc)
+{
+	STABLESORT Sort;
+	INT nRemain, nLow, nMinRun, nRunLen, nForce, n;
+	if (NULL == pTable || NULL == CompareFunc || uEnd - uStart >= 0x7fffffff)
+	{
+		return CAPI_FAILED;
+	}
+	if (uEnd <= uStart)
+	{
+		return CAPI_SUCCESS;
+	}
+	Sort.pTable = pTable;
+	Sort.ppBase = pTable->ppData + uStart;
+	Sort.CompareFunc = CompareFunc;
+	Sort.nMinGallop = STABLESORT_MIN_GALLOP;
+	Sort.nRunCount = 0;
+	nRemain = (INT)(uEnd - uStart + 1);
+
+	/*small range is sorted by binary insertion sort directly*/
+	if (nRemain < STABLESORT_MIN_MERGE)
+	{
+		nRunLen = StableSort_CountRun(&Sort, 0, nRemain);
+		StableSort_BinaryInsertSort(&Sort, 0, nRemain, nRunLen);
+		return CAPI_SUCCESS;
+	}
+
+	Sort.ppTemp = (void **)malloc((nRemain / 2 + 1) * sizeof(void *));
+	if (NULL == Sort.ppTemp)
+	{
+		return CAPI_FAILED;
+	}
+	nLow = 0;
+	nMinRun = StableSort_MinRun(nRemain);
+	do
+	{
+		nRunLen = StableSort_CountRun(&Sort, nLow, nLow + nRemain);
+		/*extend the short run to nMinRun*/
+		if (nRunLen < nMinRun)
+		{
+			nForce = nRemain <= nMinRun ? nRemain : nMinRun;
+			StableSort_BinaryInsertSort(&Sort, nLow, nLow + nForce, nLow + nRunLen);
+			nRunLen = nForce;
+		}
+		Sort.anRunBase[Sort.nRunCount] = nLow;
+		Sort.anRunLen[Sort.nRunCount] = nRunLen;
+		++Sort.nRunCount;
+		SORTSTATS_DEPTH(pTable, (UINT)Sort.nRunCount);
+		StableSort_MergeCollapse(&Sort);
+		nLow += nRunLen;
+		nRemain -= nRunLen;
+	} while (0 != nRemain);
+
+	/*merge all remaining runs*/
+	while (Sort.nRunCount > 1)
+	{
+		n = Sort.nRunCount - 2;
+		if (n > 0 && Sort.anRunLen[n - 1] < Sort.anRunLen[n + 1])
+		{
+			--n;
+		}
+		StableSort_MergeAt(&Sort, n);
+	}
+	free(Sort.ppTemp);
+	return CAPI_SUCCESS;
+}
@@ -0,0 +1,409 @@
+/*********************************************************************************
+ * FileName:	staticBTree.c
+ * Author:		gehan
+ * Date:		07/11/2017
+ * Description: Immutable static B-tree (S-tree) of 32-bit or 64-bit keys, each node
+ *				has 16 keys which are compared with the query at once by AVX2 or
+ *				SSE, the children of node k are k * 17 + 1 ... k * 17 + 17
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#include "quickSort.c"
+#include "cpu.c"
+
+#define STATICBTREE_B			16		/*the key count of a node*/
+#define STATICBTREE_ALIGN		64		/*the nodes are aligned to cache line*/
+#define STATICBTREE_BATCH		16		/*the query count searched together*/
+
+#define STATICBTREE_BIAS32		0x80000000U
+#define STATICBTREE_BIAS64		0x8000000000000000ULL
+#define STATICBTREE_MAX32		0xFFFFFFFFULL
+#define STATICBTREE_MAX64		0xFFFFFFFFFFFFFFFFULL
+
+typedef struct STATICBTREE_st STATICBTREE;
+
+struct STATICBTREE_st {
+	void *pNode;		/*the nodes, the keys are xor-ed with the sign bit so they can be compared as signed*/
+	UINT *puRank;		/*the index in table of each key, the last one is uCount*/
+	void *pNodeBuf;		/*the allocated buffer of pNode*/
+	UINT uCount;
+	UINT uBlockCount;	/*the count of nodes*/
+	UINT uHeight;
+	UINT uKeyBytes;		/*4 or 8*/
+	UINT (*LowerBound)(STATICBTREE *pTree, UINT64 uKey);
+	void (*LowerBoundBatch)(STATICBTREE *pTree, const UINT64 *puKey, UINT uCount, UINT *puRank);
+};
+
+/*
+ * the functions get the count of keys which are less than Key in a node
+ */
+static UINT StaticBTree_Rank32(const INT32 *pNode, INT32 Key)
+{
+	UINT i, uRank = 0;
+	for (i = 0; i < STATICBTREE_B; ++i)
+	{
+		uRank += (pNode[i] < Key);
+	}
+	return uRank;
+}
+
+static UINT StaticBTree_Rank64(const INT64 *pNode, INT64 Key)
+{
+	UINT i, uRank = 0;
+	for (i = 0; i < STATICBTREE_B; ++i)
+	{
+		uRank += (pNode[i] < Key);
+	}
+	return uRank;
+}
+
+#if defined(CPU_X86)
+/*the keys of node is sorted, so the compare mask is 2^rank - 1*/
+static CPU_TARGET_SSE2 UINT StaticBTree_Rank32Sse(const INT32 *pNode, INT32 Key)
+{
+	__m128i Query = _mm_set1_epi32(Key);
+	UINT uMask;
+	uMask = (UINT)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(Query,
+		_mm_load_si128((const __m128i *)pNode))));
+	uMask |= (UINT)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(Query,
+		_mm_load_si128((const __m128i *)(pNode + 4))))) << 4;
+	uMask |= (UINT)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(Query,
+		_mm_load_si128((const __m128i *)(pNode + 8))))) << 8;
+	uMask |= (UINT)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(Query,
+		_mm_load_si128((const __m128i *)(pNode + 12))))) << 12;
+	return Cpu_TrailingZero(uMask + 1);
+}
+
+static CPU_TARGET_AVX2 UINT StaticBTree_Rank32Avx2(const INT32 *pNode, INT32 Key)
+{
+	__m256i Query = _mm256_set1_epi32(Key);
+	UINT uMask;
+	uMask = (UINT)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(Query,
+		_mm256_load_si256((const __m256i *)pNode))));
+	uMask |= (UINT)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(Query,
+		_mm256_load_si256((const __m256i *)(pNode + 8))))) << 8;
+	return Cpu_TrailingZero(uMask + 1);
+}
+
+static CPU_TARGET_SSE42 UINT StaticBTree_Rank64Sse(const INT64 *pNode, INT64 Key)
+{
+	__m128i Query = _mm_set1_epi64x(Key);
+	UINT uMask = 0;
+	UINT i;
+	for (i = 0; i < STATICBTREE_B; i += 2)
+	{
+		uMask |= (UINT)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(Query,
+			_mm_load_si128((const __m128i *)(pNode + i))))) << i;
+	}
+	return Cpu_TrailingZero(uMask + 1);
+}
+
+static CPU_TARGET_AVX2 UINT StaticBTree_Rank64Avx2(const INT64 *pNode, INT64 Key)
+{
+	__m256i Query = _mm256_set1_epi64x(Key);
+	UINT uMask;
+	uMask = (UINT)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(Query,
+		_mm256_load_si256((const __m256i *)pNode))));
+	uMask |= (UINT)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(Query,
+		_mm256_load_si256((const __m256i *)(pNode + 4))))) << 4;
+	uMask |= (UINT)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(Query,
+		_mm256_load_si256((const __m256i *)(pNode + 8))))) << 8;
+	uMask |= (UINT)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(Query,
+		_mm256_load_si256((const __m256i *)(pNode + 12))))) << 12;
+	return Cpu_TrailingZero(uMask + 1);
+}
+#endif
+
+/*
+ * generate the single and batch lower bound functions of a key type
+ * @param Name -- the prefix of generated functions
+ * @param TYPE -- the signed type of keys in node
+ * @param UTYPE -- the unsigned type of keys
+ * @param BIAS -- the sign bit of key
+ * @param MAXKEY -- the max key, the rank of greater query is uCount
+ * @param RANK -- the function which gets the rank of query in a node
+ * @param TARGET -- the target attribute of RANK
+ */
+#define STATICBTREE_DEFINE(Name, TYPE, UTYPE, BIAS, MAXKEY, RANK, TARGET)				\
+static TARGET UINT Name##_LowerBound(STATICBTREE *pTree, UINT64 uKey)					\
+{																						\
+	const TYPE *pNode = (const TYPE *)pTree->pNode;										\
+	UINT uBlock = 0;																	\
+	UINT uSlot = pTree->uBlockCount * STATICBTREE_B;									\
+	UINT i;																				\
+	TYPE Key;																			\
+	if (uKey > MAXKEY)																	\
+	{																					\
+		return pTree->uCount;															\
+	}																					\
+	Key = (TYPE)(UTYPE)(uKey ^ BIAS);													\
+	while (uBlock < pTree->uBlockCount)													\
+	{																					\
+		i = RANK(pNode + uBlock * STATICBTREE_B, Key);									\
+		uSlot = (i < STATICBTREE_B) ? uBlock * STATICBTREE_B + i : uSlot;				\
+		uBlock = uBlock * (STATICBTREE_B + 1) + i + 1;									\
+	}																					\
+	return pTree->puRank[uSlot];														\
+}																						\
+static TARGET void Name##_LowerBoundBatch(STATICBTREE *pTree, const UINT64 *puKey,		\
+	UINT uCount, UINT *puRank)															\
+{																						\
+	const TYPE *pNode = (const TYPE *)pTree->pNode;										\
+	UINT auBlock[STATICBTREE_BATCH];													\
+	UINT auSlot[STATICBTREE_BATCH];														\
+	TYPE aKey[STATICBTREE_BATCH];														\
+	UINT uStart, uSize, uLevel, i, j;													\
+	for (uStart = 0; uStart < uCount; uStart += uSize)									\
+	{																					\
+		uSize = uCount - uStart;														\
+		uSize = uSize < STATICBTREE_BATCH ? uSize : STATICBTREE_BATCH;					\
+		for (j = 0; j < uSize; ++j)														\
+		{																				\
+			auBlock[j] = (puKey[uStart + j] > MAXKEY) ? pTree->uBlockCount : 0;			\
+			auSlot[j] = pTree->uBlockCount * STATICBTREE_B;								\
+			aKey[j] = (TYPE)(UTYPE)(puKey[uStart + j] ^ BIAS);							\
+		}																				\
+		/*the queries go down one level together, so their cache misses overlap*/		\
+		for (uLevel = 0; uLevel < pTree->uHeight; ++uLevel)								\
+		{																				\
+			for (j = 0; j < uSize; ++j)													\
+			{																			\
+				if (auBlock[j] < pTree->uBlockCount)									\
+				{																		\
+					i = RANK(pNode + auBlock[j] * STATICBTREE_B, aKey[j]);				\
+					auSlot[j] = (i < STATICBTREE_B) ? auBlock[j] * STATICBTREE_B + i	\
+						: auSlot[j];													\
+					auBlock[j] = auBlock[j] * (STATICBTREE_B + 1) + i + 1;				\
+					Prefetch(pNode + (size_t)auBlock[j] * STATICBTREE_B);				\
+				}																		\
+			}																			\
+		}																				\
+		for (j = 0; j < uSize; ++j)														\
+		{																				\
+			puRank[uStart + j] = pTree->puRank[auSlot[j]];								\
+		}																				\
+	}																					\
+}
+
+#define STATICBTREE_NO_TARGET
+
+STATICBTREE_DEFINE(StaticBTree32, INT32, UINT32, STATICBTREE_BIAS32, STATICBTREE_MAX32,
+	StaticBTree_Rank32, STATICBTREE_NO_TARGET)
+STATICBTREE_DEFINE(StaticBTree64, INT64, UINT64, STATICBTREE_BIAS64, STATICBTREE_MAX64,
+	StaticBTree_Rank64, STATICBTREE_NO_TARGET)
+#if defined(CPU_X86)
+STATICBTREE_DEFINE(StaticBTree32Sse, INT32, UINT32, STATICBTREE_BIAS32, STATICBTREE_MAX32,
+	StaticBTree_Rank32Sse, CPU_TARGET_SSE2)
+STATICBTREE_DEFINE(StaticBTree32Avx2, INT32, UINT32, STATICBTREE_BIAS32, STATICBTREE_MAX32,
+	StaticBTree_Rank32Avx2, CPU_TARGET_AVX2)
+STATICBTREE_DEFINE(StaticBTree64Sse, INT64, UINT64, STATICBTREE_BIAS64, STATICBTREE_MAX64,
+	StaticBTree_Rank64Sse, CPU_TARGET_SSE42)
+STATICBTREE_DEFINE(StaticBTree64Avx2, INT64, UINT64, STATICBTREE_BIAS64, STATICBTREE_MAX64,
+	StaticBTree_Rank64Avx2, CPU_TARGET_AVX2)
+#endif
+
+/*
+ * fill the subtree of node uBlock by in-order traversal, the empty slots
+ * are filled by the max key and the rank uCount
+ * @param STATICBTREE *pTree
+ * @param const UINT64 *puKey -- the sorted keys
+ * @param UINT uRank -- the index of next key in puKey
+ * @param UINT uBlock
+ * @return UINT -- the index of next key after the subtree is filled
+ */
+static UINT StaticBTree_Build(STATICBTREE *pTree, const UINT64 *puKey, UINT uRank, UINT uBlock)
+{
+	UINT uSlot;
+	UINT i;
+	UINT64 uKey;
+	if (uBlock >= pTree->uBlockCount)
+	{
+		return uRank;
+	}
+	for (i = 0; i < STATICBTREE_B; ++i)
+	{
+		uRank = StaticBTree_Build(pTree, puKey, uRank, uBlock * (STATICBTREE_B + 1) + i + 1);
+		uSlot = uBlock * STATICBTREE_B + i;
+		if (uRank < pTree->uCount)
+		{
+			uKey = puKey[uRank];
+			pTree->puRank[uSlot] = uRank;
+			++uRank;
+		}
+		else
+		{
+			uKey = STATICBTREE_MAX64;
+			pTree->puRank[uSlot] = pTree->uCount;
+		}
+		if (4 == pTree->uKeyBytes)
+		{
+			((INT32 *)pTree->pNode)[uSlot] = (INT32)(UINT32)(uKey ^ STATICBTREE_BIAS32);
+		}
+		else
+		{
+			((INT64 *)pTree->pNode)[uSlot] = (INT64)(uKey ^ STATICBTREE_BIAS64);
+		}
+	}
+	return StaticBTree_Build(pTree, puKey, uRank, uBlock * (STATICBTREE_B + 1) + STATICBTREE_B + 1);
+}
+
+/*
+ * Destroy static B-tree
+ * @param STATICBTREE *pTree
+ * @return void
+ */
+void StaticBTree_Destroy(STATICBTREE *pTree)
+{
+	if (NULL == pTree)
+	{
+		return;
+	}
+	free(pTree->pNodeBuf);
+	free(pTree->puRank);
+	free(pTree);
+}
+
+/*
+ * Create static B-tree from a sort table, the table must be sorted in the order
+ * of keys. The search functions are chosen by the instruction sets of CPU
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param GETKEY64FUNC GetKeyFunc -- the function of get key of data
+ * @param UINT uKeyBytes -- 4 or 8, the keys must be less than 2^32 if it is 4
+ * @return STATICBTREE * -- return NULL if failed
+ */
+STATICBTREE * StaticBTree_Create(SORTTABLE *pTable, GETKEY64FUNC GetKeyFunc, UINT uKeyBytes)
+{
+	STATICBTREE *pTree;
+	UINT64 *puKey;
+	UINT uFeatures;
+	UINT uBlock;
+	UINT i;
+	if (NULL == pTable || NULL == GetKeyFunc || (4 != uKeyBytes && 8 != uKeyBytes))
+	{
+		return NULL;
+	}
+	pTree = (STATICBTREE *)calloc(1, sizeof(STATICBTREE));
+	if (NULL == pTree)
+	{
+		return NULL;
+	}
+	pTree->uCount = pTable->uCursorCount;
+	pTree->uKeyBytes = uKeyBytes;
+	pTree->uBlockCount = (pTree->uCount + STATICBTREE_B - 1) / STATICBTREE_B;
+	pTree->pNodeBuf = malloc((size_t)pTree->uBlockCount * STATICBTREE_B * uKeyBytes + STATICBTREE_ALIGN);
+	pTree->puRank = (UINT *)malloc(((size_t)pTree->uBlockCount * STATICBTREE_B + 1) * sizeof(UINT));
+	puKey = (UINT64 *)malloc((pTree->uCount + 1) * sizeof(UINT64));
+	if (NULL == pTree->pNodeBuf || NULL == pTree->puRank || NULL == puKey)
+	{
+		free(puKey);
+		StaticBTree_Destroy(pTree);
+		return NULL;
+	}
+	pTree->pNode = (void *)(((size_t)pTree->pNodeBuf + STATICBTREE_ALIGN - 1)
+		& ~(size_t)(STATICBTREE_ALIGN - 1));
+	for (i = 0; i < pTree->uCount; ++i)
+	{
+		puKey[i] = (*GetKeyFunc)(pTable->ppData[i]);
+	}
+	(void)StaticBTree_Build(pTree, puKey, 0, 0);
+	pTree->puRank[pTree->uBlockCount * STATICBTREE_B] = pTree->uCount;
+	free(puKey);
+
+	/*the leftmost path is the longest one*/
+	for (uBlock = 0; uBlock < pTree->uBlockCount; uBlock = uBlock * (STATICBTREE_B + 1) + 1)
+	{
+		++pTree->uHeight;
+	}
+
+	uFeatures = Cpu_GetFeatures();
+	if (4 == uKeyBytes)
+	{
+		pTree->LowerBound = StaticBTree32_LowerBound;
+		pTree->LowerBoundBatch = StaticBTree32_LowerBoundBatch;
+#if defined(CPU_X86)
+		if (uFeatures & CPU_FEATURE_AVX2)
+		{
+			pTree->LowerBound = StaticBTree32Avx2_LowerBound;
+			pTree->LowerBoundBatch = StaticBTree32Avx2_LowerBoundBatch;
+		}
+		else if (uFeatures & CPU_FEATURE_SSE2)
+		{
+			pTree->LowerBound = StaticBTree32Sse_LowerBound;
+			pTree->LowerBoundBatch = StaticBTree32Sse_LowerBoundBatch;
+		}
+#endif
+	}
+	else
+	{
+		pTree->LowerBound = StaticBTree64_LowerBound;
+		pTree->LowerBoundBatch = StaticBTree64_LowerBoundBatch;
+#if defined(CPU_X86)
+		if (uFeatures & CPU_FEATURE_AVX2)
+		{
+			pTree->LowerBound = StaticBTree64Avx2_LowerBound;
+			pTree->LowerBoundBatch = StaticBTree64Avx2_LowerBoundBatch;
+		}
+		else if (uFeatures & CPU_FEATURE_SSE42)
+		{
+			pTree->LowerBound = StaticBTree64Sse_LowerBound;
+			pTree->LowerBoundBatch = StaticBTree64Sse_LowerBoundBatch;
+		}
+#endif
+	}
+	(void)uFeatures;
+	return pTree;
+}
+
+/*
+ * get the index in table of the first key which is not less than uKey
+ * @param STATICBTREE *pTree
+ * @param UINT64 uKey
+ * @return UINT -- return uCount if all keys are less than uKey
+ */
+UINT StaticBTree_LowerBound(STATICBTREE *pTree, UINT64 uKey)
+{
+	if (NULL == pTree)
+	{
+		return 0;
+	}
+	return (*pTree->LowerBound)(pTree, uKey);
+}
+
+/*
+ * get the count of keys in [uLow, uHigh]
+ * @param STATICBTREE *pTree
+ * @param UINT64 uLow
+ * @param UINT64 uHigh
+ * @return UINT
+ */
+UINT StaticBTree_RangeCount(STATICBTREE *pTree, UINT64 uLow, UINT64 uHigh)
+{
+	UINT uStart, uEnd;
+	if (NULL == pTree || uLow > uHigh)
+	{
+		return 0;
+	}
+	uStart = (*pTree->LowerBound)(pTree, uLow);
+	uEnd = (STATICBTREE_MAX64 == uHigh) ? pTree->uCount : (*pTree->LowerBound)(pTree, uHigh + 1);
+	return uEnd - uStart;
+}
+
+/*
+ * get the lower bounds of many keys, it is faster than calling
+ * StaticBTree_LowerBound for each key since the memory accesses overlap
+ * @param STATICBTREE *pTree
+ * @param const UINT64 *puKey -- the keys to search
+ * @param UINT uCount -- the count of keys
+ * @param UINT *puRank -- the result of each key
+ * @return INT
+ */
+INT StaticBTree_LowerBoundBatch(STATICBTREE *pTree, const UINT64 *puKey, UINT uCount, UINT *puRank)
+{
+	if (NULL == pTree || NULL == puKey || NULL == puRank)
+	{
+		return CAPI_FAILED;
+	}
+	(*pTree->LowerBoundBatch)(pTree, puKey, uCount, puRank);
+	return CAPI_SUCCESS;
+}
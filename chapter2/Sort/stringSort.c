@@ -0,0 +1,381 @@
+/*********************************************************************************
+ * FileName:	stringSort.c
+ * Author:		gehan
+ * Date:		07/18/2017
+ * Description: String sort of sort table which data are C strings, 8 bytes of
+ *				each string are cached beside its pointer so the shared prefixes
+ *				are read once for 8 bytes. The large ranges are split by MSD
+ *				radix sort on the cached bytes and the others are sorted by
+ *				multikey quicksort
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+#include "quickSort.c"
+
+/* the range which has less strings than this value is sorted by insertion sort */
+#define STRINGSORT_INSERT_THRESHOLD	16
+/* the range which has more strings than this value is split by MSD radix sort */
+#define STRINGSORT_RADIX_THRESHOLD	32768
+/* the distance of prefetching the strings when the caches are loaded */
+#define STRINGSORT_PREFETCH_DISTANCE	16
+
+/*
+ * the string and its 8 bytes from current depth in big-endian order,
+ * the bytes after the end of string are 0
+ */
+typedef struct STRINGITEM_st {
+	const unsigned char *pszStr;
+	UINT64 uCache;
+}STRINGITEM;
+
+/*
+ * the buffers of MSD radix sort
+ */
+typedef struct STRINGSORT_st {
+	STRINGITEM *pBuffer;		/*the scatter buffer, it is NULL if radix sort is not used*/
+	unsigned char *pOracle;		/*the byte of each string at current depth*/
+}STRINGSORT;
+
+/*
+ * load the cached bytes of strings at a depth, all strings are longer than uDepth
+ * @param STRINGITEM *pItem
+ * @param UINT uCount
+ * @param UINT uDepth
+ * @return void
+ */
+static void StringSort_LoadCache(STRINGITEM *pItem, UINT uCount, UINT uDepth)
+{
+	const unsigned char *pszStr;
+	UINT64 uCache;
+	UINT i, j;
+	for (i = 0; i < uCount; ++i)
+	{
+		if (i + STRINGSORT_PREFETCH_DISTANCE < uCount)
+		{
+			Prefetch(pItem[i + STRINGSORT_PREFETCH_DISTANCE].pszStr + uDepth);
+		}
+		pszStr = pItem[i].pszStr + uDepth;
+		uCache = 0;
+		for (j = 0; j < 8 && '\0' != pszStr[j]; ++j)
+		{
+			uCache |= (UINT64)pszStr[j] << (56 - 8 * j);
+		}
+		pItem[i].uCache = uCache;
+	}
+}
+
+/*
+ * the cached bytes contain the end of string, so the strings with equal
+ * cache are equal
+ */
+#define STRINGSORT_IS_END(uCache)	(0 == ((uCache) & 0xFF))
+
+/*
+ * compare two strings, the caches are loaded at uDepth
+ * @param STRINGITEM *pItem1
+ * @param STRINGITEM *pItem2
+ * @param UINT uDepth
+ * @return INT
+ */
+static INT StringSort_Compare(STRINGITEM *pItem1, STRINGITEM *pItem2, UINT uDepth)
+{
+	if (pItem1->uCache != pItem2->uCache)
+	{
+		return pItem1->uCache < pItem2->uCache ? -1 : 1;
+	}
+	if (STRINGSORT_IS_END(pItem1->uCache))
+	{
+		return 0;
+	}
+	return strcmp((const char *)pItem1->pszStr + uDepth + 8, (const char *)pItem2->pszStr + uDepth + 8);
+}
+
+/*
+ * insertion sort of strings, the caches are loaded at uDepth
+ * @param STRINGITEM *pItem
+ * @param UINT uCount
+ * @param UINT uDepth
+ * @return void
+ */
+static void StringSort_InsertSort(STRINGITEM *pItem, UINT uCount, UINT uDepth)
+{
+	STRINGITEM Item;
+	UINT i, j;
+	for (i = 1; i < uCount; ++i)
+	{
+		Item = pItem[i];
+		j = i;
+		while (j > 0 && StringSort_Compare(&pItem[j - 1], &Item, uDepth) > 0)
+		{
+			pItem[j] = pItem[j - 1];
+			--j;
+		}
+		pItem[j] = Item;
+	}
+}
+
+/*
+ * get the median of three caches
+ * @return UINT64
+ */
+static UINT64 StringSort_Median(UINT64 a, UINT64 b, UINT64 c)
+{
+	if (a < b)
+	{
+		return b < c ? b : (a < c ? c : a);
+	}
+	return a < c ? a : (b < c ? c : b);
+}
+
+static void StringSort_Radix(STRINGSORT *pSort, STRINGITEM *pItem, UINT uCount, UINT uDepth, UINT uByte);
+
+/*
+ * multikey quicksort of strings, the caches are loaded at uDepth. The range is
+ * split into <, = and > parts by the cache of pivot, the = part goes on with
+ * the next 8 bytes and the largest part is sorted in the loop
+ * @param STRINGSORT *pSort
+ * @param STRINGITEM *pItem
+ * @param UINT uCount
+ * @param UINT uDepth
+ * @return void
+ */
+static void StringSort_MultiKey(STRINGSORT *pSort, STRINGITEM *pItem, UINT uCount, UINT uDepth)
+{
+	STRINGITEM Temp;
+	UINT64 uPivot;
+	UINT uLess, uGreater;
+	UINT uLessCount, uEqualCount, uGreaterCount;
+	UINT i, uStep;
+	while (uCount > STRINGSORT_INSERT_THRESHOLD)
+	{
+		if (uCount > STRINGSORT_RADIX_THRESHOLD && NULL != pSort->pBuffer)
+		{
+			StringSort_Radix(pSort, pItem, uCount, uDepth, 0);
+			return;
+		}
+		/*pseudo median of 9 for the large range*/
+		if (uCount > 128)
+		{
+			uStep = uCount / 8;
+			uPivot = StringSort_Median(
+				StringSort_Median(pItem[0].uCache, pItem[uStep].uCache, pItem[2 * uStep].uCache),
+				StringSort_Median(pItem[3 * uStep].uCache, pItem[4 * uStep].uCache, pItem[5 * uStep].uCache),
+				StringSort_Median(pItem[6 * uStep].uCache, pItem[7 * uStep].uCache, pItem[uCount - 1].uCache));
+		}
+		else
+		{
+			uPivot = StringSort_Median(pItem[0].uCache, pItem[uCount / 2].uCache, pItem[uCount - 1].uCache);
+		}
+
+		/*the [0, uLess) is less, [uLess, i) is equal and [uGreater, uCount) is greater*/
+		uLess = 0;
+		uGreater = uCount;
+		i = 0;
+		while (i < uGreater)
+		{
+			if (pItem[i].uCache < uPivot)
+			{
+				Temp = pItem[i];
+				pItem[i] = pItem[uLess];
+				pItem[uLess] = Temp;
+				++uLess;
+				++i;
+			}
+			else if (pItem[i].uCache > uPivot)
+			{
+				--uGreater;
+				Temp = pItem[i];
+				pItem[i] = pItem[uGreater];
+				pItem[uGreater] = Temp;
+			}
+			else
+			{
+				++i;
+			}
+		}
+		uLessCount = uLess;
+		uEqualCount = uGreater - uLess;
+		uGreaterCount = uCount - uGreater;
+
+		/*the equal strings are sorted by next 8 bytes unless they have ended*/
+		if (STRINGSORT_IS_END(uPivot))
+		{
+			uEqualCount = 0;
+		}
+		else if (uEqualCount > 1 && uEqualCount < uLessCount + uGreaterCount)
+		{
+			StringSort_LoadCache(pItem + uLess, uEqualCount, uDepth + 8);
+			StringSort_MultiKey(pSort, pItem + uLess, uEqualCount, uDepth + 8);
+			uEqualCount = 0;
+		}
+
+		/*recurse into the smaller parts and loop on the largest one*/
+		if (uEqualCount >= uLessCount && uEqualCount >= uGreaterCount)
+		{
+			StringSort_MultiKey(pSort, pItem, uLessCount, uDepth);
+			StringSort_MultiKey(pSort, pItem + uGreater, uGreaterCount, uDepth);
+			pItem += uLess;
+			uCount = uEqualCount;
+			uDepth += 8;
+			StringSort_LoadCache(pItem, uCount, uDepth);
+		}
+		else if (uLessCount >= uGreaterCount)
+		{
+			StringSort_MultiKey(pSort, pItem + uGreater, uGreaterCount, uDepth);
+			uCount = uLessCount;
+		}
+		else
+		{
+			StringSort_MultiKey(pSort, pItem, uLessCount, uDepth);
+			pItem += uGreater;
+			uCount = uGreaterCount;
+		}
+	}
+	StringSort_InsertSort(pItem, uCount, uDepth);
+}
+
+/*
+ * MSD radix sort of strings on the byte uByte of the caches, the strings are
+ * accessed only when the caches are loaded with next 8 bytes. The bytes are
+ * read into the oracle first, and the strings are scattered into the buffer
+ * and copied back
+ * @param STRINGSORT *pSort
+ * @param STRINGITEM *pItem
+ * @param UINT uCount
+ * @param UINT uDepth -- the depth of the caches
+ * @param UINT uByte -- the byte index in the cache, the bytes before it are equal,
+ *						8 means all cached bytes are equal
+ * @return void
+ */
+static void StringSort_Radix(STRINGSORT *pSort, STRINGITEM *pItem, UINT uCount, UINT uDepth, UINT uByte)
+{
+	UINT auCount[256];
+	UINT auStart[256];
+	UINT64 uDiff;
+	UINT uShift;
+	UINT uSum;
+	UINT i;
+
+	/*skip the bytes which are the same in all strings, such as the common prefix*/
+	uDiff = 0;
+	for (i = 1; i < uCount; ++i)
+	{
+		uDiff |= pItem[i].uCache ^ pItem[0].uCache;
+	}
+	uDiff = uByte < 8 ? uDiff & (~(UINT64)0 >> (8 * uByte)) : 0;
+	while (0 == uDiff)
+	{
+		if (STRINGSORT_IS_END(pItem[0].uCache))
+		{
+			return;
+		}
+		uDepth += 8;
+		uByte = 0;
+		StringSort_LoadCache(pItem, uCount, uDepth);
+		for (i = 1; i < uCount; ++i)
+		{
+			uDiff |= pItem[i].uCache ^ pItem[0].uCache;
+		}
+	}
+	while (0 == (uDiff >> (56 - 8 * uByte)))
+	{
+		++uByte;
+	}
+	uShift = 56 - 8 * uByte;
+	memset(auCount, 0, sizeof(auCount));
+	for (i = 0; i < uCount; ++i)
+	{
+		pSort->pOracle[i] = (unsigned char)(pItem[i].uCache >> uShift);
+		++auCount[pSort->pOracle[i]];
+	}
+	uSum = 0;
+	for (i = 0; i < 256; ++i)
+	{
+		auStart[i] = uSum;
+		uSum += auCount[i];
+	}
+	for (i = 0; i < uCount; ++i)
+	{
+		pSort->pBuffer[auStart[pSort->pOracle[i]]++] = pItem[i];
+	}
+	memcpy(pItem, pSort->pBuffer, uCount * sizeof(STRINGITEM));
+
+	/*the strings of bucket 0 have ended, and they are equal*/
+	uSum = auCount[0];
+	for (i = 1; i < 256; ++i)
+	{
+		if (auCount[i] > STRINGSORT_RADIX_THRESHOLD)
+		{
+			StringSort_Radix(pSort, pItem + uSum, auCount[i], uDepth, uByte + 1);
+		}
+		else if (auCount[i] > 1)
+		{
+			/*the bytes before uByte are equal, so the caches still work*/
+			StringSort_MultiKey(pSort, pItem + uSum, auCount[i], uDepth);
+		}
+		uSum += auCount[i];
+	}
+}
+
+/*
+ * the string sort function of sort table, the data of table must be C strings.
+ * The strings are sorted in the order of strcmp and it is not stable
+ * @param SORTTABLE *pTable	-- the sort table's pointer
+ * @param UINT uStart
+ * @param UINT uEnd
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED, the table is not changed if failed
+ */
+INT SortTable_StringSort(SORTTABLE *pTable, UINT uStart, UINT uEnd)
+{
+	STRINGSORT Sort;
+	STRINGITEM *pItem;
+	UINT uCount;
+	UINT i;
+	if (NULL == pTable)
+	{
+		return CAPI_FAILED;
+	}
+	if (uEnd <= uStart)
+	{
+		return CAPI_SUCCESS;
+	}
+	uCount = uEnd - uStart + 1;
+	pItem = (STRINGITEM *)malloc(uCount * sizeof(STRINGITEM));
+	if (NULL == pItem)
+	{
+		return CAPI_FAILED;
+	}
+	Sort.pBuffer = NULL;
+	Sort.pOracle = NULL;
+	if (uCount > STRINGSORT_RADIX_THRESHOLD)
+	{
+		/*it falls back to multikey quicksort if the buffers can't be allocated*/
+		Sort.pBuffer = (STRINGITEM *)malloc(uCount * sizeof(STRINGITEM));
+		Sort.pOracle = (unsigned char *)malloc(uCount);
+		if (NULL == Sort.pBuffer || NULL == Sort.pOracle)
+		{
+			free(Sort.pBuffer);
+			free(Sort.pOracle);
+			Sort.pBuffer = NULL;
+			Sort.pOracle = NULL;
+		}
+	}
+
+	for (i = 0; i < uCount; ++i)
+	{
+		pItem[i].pszStr = (const unsigned char *)pTable->ppData[uStart + i];
+	}
+	StringSort_LoadCache(pItem, uCount, 0);
+	StringSort_MultiKey(&Sort, pItem, uCount, 0);
+	for (i = 0; i < uCount; ++i)
+	{
+		pTable->ppData[uStart + i] = (void *)pItem[i].pszStr;
+	}
+
+	free(Sort.pBuffer);
+	free(Sort.pOracle);
+	free(pItem);
+	return CAPI_SUCCESS;
+}
@@ -0,0 +1,315 @@
+/*********************************************************************************
+ * FileName:	bench_queue.c
+ * Author:		gehan
+ * Date:		07/24/2017
+ * Description: Contention benchmark of the concurrent queues, each thread inserts
+ *				and pops in pairs, and the total throughput and the percentiles of
+ *				the sampled pair latency are written as JSON for 1, 2, 4 ... max
+ *				threads.
+ *				build:	cc -O2 -I../.. bench_queue.c -o bench_queue (add -pthread on Linux)
+ *				usage:	bench_queue [-t max_threads] [-n pairs_per_thread] [-o file.json]
+**********************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include "algo.h"
+#include "queue.c"
+#include "mpmcQueue.c"
+
+#define BENCH_CAPACITY      1024
+#define BENCH_SAMPLE_STEP   16      /* the latency of one pair in every 16 pairs is sampled */
+
+/*
+ * the queue guarded by a mutex
+ */
+typedef struct BENCHMUTEX_st{
+    QUEUE *pQueue;
+    LOCK pLock;
+}BENCHMUTEX;
+
+typedef struct BENCHQUEUE_st{
+    const char *pszName;
+    void *(*CreateFunc)(void);
+    void (*DestroyFunc)(void *pQueue);
+    void (*InsertFunc)(void *pQueue, void *pData);
+    void *(*PopFunc)(void *pQueue);
+}BENCHQUEUE;
+
+/*
+ * the argument of benchmark thread
+ */
+typedef struct BENCHWORKER_st{
+    BENCHQUEUE *pKind;
+    void *pQueue;
+    UINT uPairCount;
+    double *pLatency;           /* the sampled latency in nanoseconds */
+    volatile LONG *plReady;     /* the count of threads which are ready */
+    volatile LONG *plStart;     /* it becomes nonzero when all threads are ready */
+}BENCHWORKER;
+
+typedef struct BENCHRESULT_st{
+    double dMops;               /* negative if failed */
+    double dP50;
+    double dP99;
+    double dP999;
+}BENCHRESULT;
+
+static double Bench_Now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER Counter, Frequency;
+    QueryPerformanceCounter(&Counter);
+    QueryPerformanceFrequency(&Frequency);
+    return (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (double)Time.tv_sec + (double)Time.tv_nsec * 1e-9;
+#endif
+}
+
+static void *Bench_MutexCreate(void)
+{
+    BENCHMUTEX *pMutex = (BENCHMUTEX *)malloc(sizeof(BENCHMUTEX));
+    if(NULL == pMutex)
+        return NULL;
+    pMutex->pQueue = Queue_Create(BENCH_CAPACITY);
+    pMutex->pLock = LockCreate();
+    if(NULL == pMutex->pQueue || NULL == pMutex->pLock)
+    {
+        if(pMutex->pQueue != NULL)
+            Queue_Destroy(pMutex->pQueue, NULL);
+        if(pMutex->pLock != NULL)
+            LockClose(pMutex->pLock);
+        free(pMutex);
+        return NULL;
+    }
+    return pMutex;
+}
+
+static void Bench_MutexDestroy(void *pQueue)
+{
+    BENCHMUTEX *pMutex = (BENCHMUTEX *)pQueue;
+    Queue_Destroy(pMutex->pQueue, NULL);
+    LockClose(pMutex->pLock);
+    free(pMutex);
+}
+
+static void Bench_MutexInsert(void *pQueue, void *pData)
+{
+    BENCHMUTEX *pMutex = (BENCHMUTEX *)pQueue;
+    Lock(pMutex->pLock);
+    (void)Queue_InsertTail(pMutex->pQueue, pData);
+    Unlock(pMutex->pLock);
+}
+
+static void *Bench_MutexPop(void *pQueue)
+{
+    BENCHMUTEX *pMutex = (BENCHMUTEX *)pQueue;
+    void *pData;
+    Lock(pMutex->pLock);
+    pData = Queue_PopHead(pMutex->pQueue);
+    Unlock(pMutex->pLock);
+    return pData;
+}
+
+static void *Bench_MpmcCreate(void)
+{
+    return MpmcQueue_Create(BENCH_CAPACITY);
+}
+
+static void Bench_MpmcDestroy(void *pQueue)
+{
+    MpmcQueue_Destroy((MPMCQUEUE *)pQueue, NULL);
+}
+
+static void Bench_MpmcInsert(void *pQueue, void *pData)
+{
+    (void)MpmcQueue_InsertTail((MPMCQUEUE *)pQueue, pData);
+}
+
+static void *Bench_MpmcPop(void *pQueue)
+{
+    return MpmcQueue_PopHead((MPMCQUEUE *)pQueue);
+}
+
+static void Bench_MpmcTryInsert(void *pQueue, void *pData)
+{
+    while(MpmcQueue_TryInsertTail((MPMCQUEUE *)pQueue, pData) != CAPI_SUCCESS)
+        ThreadYield();
+}
+
+static void *Bench_MpmcTryPop(void *pQueue)
+{
+    void *pData;
+    while(NULL == (pData = MpmcQueue_TryPopHead((MPMCQUEUE *)pQueue)))
+        ThreadYield();
+    return pData;
+}
+
+static BENCHQUEUE g_aKind[] = {
+    { "mutex", Bench_MutexCreate, Bench_MutexDestroy, Bench_MutexInsert, Bench_MutexPop },
+    { "mpmc", Bench_MpmcCreate, Bench_MpmcDestroy, Bench_MpmcInsert, Bench_MpmcPop },
+    { "mpmc_try", Bench_MpmcCreate, Bench_MpmcDestroy, Bench_MpmcTryInsert, Bench_MpmcTryPop },
+};
+
+#define BENCH_COUNT_OF(a)   (sizeof(a) / sizeof((a)[0]))
+
+static INT Bench_CompareDouble(const void *p1, const void *p2)
+{
+    double d1 = *(const double *)p1;
+    double d2 = *(const double *)p2;
+    return d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+}
+
+/*
+ * the thread function of benchmark, it waits until all threads are ready
+ * @param void *pArg -- the BENCHWORKER pointer
+ * @return THREADRET
+ */
+static THREADRET THREADAPI Bench_Worker(void *pArg)
+{
+    BENCHWORKER *pWorker = (BENCHWORKER *)pArg;
+    BENCHQUEUE *pKind = pWorker->pKind;
+    double dStart;
+    UINT i;
+    (void)AtomicIncrement(pWorker->plReady);
+    while(0 == *pWorker->plStart)
+        ThreadYield();
+    for(i = 0; i < pWorker->uPairCount; ++i)
+    {
+        if(0 == i % BENCH_SAMPLE_STEP)
+        {
+            dStart = Bench_Now();
+            (*pKind->InsertFunc)(pWorker->pQueue, pWorker);
+            (void)(*pKind->PopFunc)(pWorker->pQueue);
+            pWorker->pLatency[i / BENCH_SAMPLE_STEP] = (Bench_Now() - dStart) * 1e9;
+        }
+        else
+        {
+            (*pKind->InsertFunc)(pWorker->pQueue, pWorker);
+            (void)(*pKind->PopFunc)(pWorker->pQueue);
+        }
+    }
+    return 0;
+}
+
+/*
+ * run a queue with some threads
+ * @param BENCHQUEUE *pKind
+ * @param UINT uThreadCount
+ * @param UINT uPairCount
+ * @param BENCHRESULT *pResult -- for saving the throughput and latency
+ * @return void
+ */
+static void Bench_Run(BENCHQUEUE *pKind, UINT uThreadCount, UINT uPairCount, BENCHRESULT *pResult)
+{
+    UINT uSampleCount = (uPairCount + BENCH_SAMPLE_STEP - 1) / BENCH_SAMPLE_STEP;
+    BENCHWORKER *pWorker = (BENCHWORKER *)malloc(uThreadCount * sizeof(BENCHWORKER));
+    THREAD *pThread = (THREAD *)malloc(uThreadCount * sizeof(THREAD));
+    double *pLatency = (double *)malloc((size_t)uThreadCount * uSampleCount * sizeof(double));
+    void *pQueue = (*pKind->CreateFunc)();
+    volatile LONG lReady = 0, lStart = 0;
+    double dStart, dTime;
+    size_t uTotal;
+    UINT uCreated;
+    UINT i;
+    memset(pResult, 0, sizeof(BENCHRESULT));
+    pResult->dMops = -1.0;
+    if(NULL == pWorker || NULL == pThread || NULL == pLatency || NULL == pQueue)
+        goto END;
+    for(uCreated = 0; uCreated < uThreadCount; ++uCreated)
+    {
+        pWorker[uCreated].pKind = pKind;
+        pWorker[uCreated].pQueue = pQueue;
+        pWorker[uCreated].uPairCount = uPairCount;
+        pWorker[uCreated].pLatency = pLatency + (size_t)uCreated * uSampleCount;
+        pWorker[uCreated].plReady = &lReady;
+        pWorker[uCreated].plStart = &lStart;
+        pThread[uCreated] = ThreadCreate(Bench_Worker, &pWorker[uCreated]);
+        if(NULL == pThread[uCreated])
+            break;
+    }
+    /* the created threads must be started even if failed, or they wait forever */
+    while(lReady != (LONG)uCreated)
+        ThreadYield();
+    dStart = Bench_Now();
+    (void)AtomicIncrement(&lStart);
+    for(i = 0; i < uCreated; ++i)
+    {
+        ThreadJoin(pThread[i]);
+        ThreadClose(pThread[i]);
+    }
+    dTime = Bench_Now() - dStart;
+    if(uCreated != uThreadCount || dTime <= 0)
+        goto END;
+    pResult->dMops = 2.0 * uPairCount * uThreadCount / dTime * 1e-6;
+    uTotal = (size_t)uThreadCount * uSampleCount;
+    qsort(pLatency, uTotal, sizeof(double), Bench_CompareDouble);
+    pResult->dP50 = pLatency[uTotal / 2];
+    pResult->dP99 = pLatency[uTotal * 99 / 100];
+    pResult->dP999 = pLatency[uTotal * 999 / 1000];
+END:
+    if(pQueue != NULL)
+        (*pKind->DestroyFunc)(pQueue);
+    free(pLatency);
+    free(pThread);
+    free(pWorker);
+}
+
+int main(int argc, char *argv[])
+{
+    UINT uMaxThread = 64;
+    UINT uPairCount = 100000;
+    const char *pszOutput = NULL;
+    FILE *pOut = stdout;
+    BENCHRESULT Result;
+    INT bFirst = 1;
+    UINT k, t;
+    INT n;
+
+    for(n = 1; n + 1 < argc; n += 2)
+    {
+        if(0 == strcmp(argv[n], "-t"))
+            uMaxThread = (UINT)strtoul(argv[n + 1], NULL, 10);
+        else if(0 == strcmp(argv[n], "-n"))
+            uPairCount = (UINT)strtoul(argv[n + 1], NULL, 10);
+        else if(0 == strcmp(argv[n], "-o"))
+            pszOutput = argv[n + 1];
+        else
+            break;
+    }
+    if(n < argc || 0 == uMaxThread || 0 == uPairCount)
+    {
+        fprintf(stderr, "usage: %s [-t max_threads] [-n pairs_per_thread] [-o file.json]\n", argv[0]);
+        return 1;
+    }
+    if(NULL != pszOutput)
+    {
+        pOut = fopen(pszOutput, "w");
+        if(NULL == pOut)
+        {
+            fprintf(stderr, "can't open %s\n", pszOutput);
+            return 1;
+        }
+    }
+
+    fprintf(pOut, "{\n  \"pairs_per_thread\": %u,\n  \"results\": [", uPairCount);
+    for(k = 0; k < BENCH_COUNT_OF(g_aKind); ++k)
+    {
+        for(t = 1; t <= uMaxThread; t *= 2)
+        {
+            Bench_Run(&g_aKind[k], t, uPairCount, &Result);
+            fprintf(pOut, "%s\n    {\"queue\": \"%s\", \"threads\": %u, \"mops\": %.3f, "
+                "\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f}",
+                bFirst ? "" : ",", g_aKind[k].pszName, t, Result.dMops,
+                Result.dP50, Result.dP99, Result.dP999);
+            bFirst = 0;
+            fflush(pOut);
+        }
+    }
+    fprintf(pOut, "\n  ]\n}\n");
+    if(stdout != pOut)
+        fclose(pOut);
+    return 0;
+}
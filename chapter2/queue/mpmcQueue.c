@@ -0,0 +1,300 @@
+/*********************************************************************************
+ * FileName:	mpmcQueue.c
+ * Author:		gehan
+ * Date:		07/24/2017
+ * Description: Lock-free bounded queue program for many producers and consumers,
+ *				each slot has a sequence number which tells whether the slot is
+ *				free for the insertion at a position or holds the data for the pop
+ *				at a position, so a thread only CASes the tail or head to claim a
+ *				position. The blocking insertion and pop spin a while and then
+ *				sleep on a semaphore until the other side wakes them
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+
+#define MPMCQUEUE_CACHE_LINE    64
+#define MPMCQUEUE_MAX_CAPACITY  0x40000000u
+#define MPMCQUEUE_SPIN          64          /* the times of trying before sleep, it yields in the latter half */
+#define MPMCQUEUE_MAX_WAKE      0x7FFFFFFF  /* the max count of semaphore */
+
+/*
+ * the slot at position p is free for insertion if uSeq == p, and holds the
+ * data for pop if uSeq == p + 1, the pop sets it to p + capacity
+ */
+typedef struct MPMCSLOT_st{
+    volatile UINT uSeq;
+    void *pData;
+}MPMCSLOT;
+
+typedef struct MPMCQUEUE_st{
+    MPMCSLOT *pSlot;
+    UINT uMask;                         /* the capacity - 1 */
+    SEMAPHORE pDataSema;                /* the sleeping pops wait on it */
+    SEMAPHORE pSlotSema;                /* the sleeping insertions wait on it */
+    char acPad0[MPMCQUEUE_CACHE_LINE];
+    volatile UINT uTail;                /* the next position to insert */
+    char acPad1[MPMCQUEUE_CACHE_LINE - sizeof(UINT)];
+    volatile UINT uHead;                /* the next position to pop */
+    char acPad2[MPMCQUEUE_CACHE_LINE - sizeof(UINT)];
+    volatile LONG lPopWaiters;          /* the count of pops which may sleep */
+    volatile LONG lInsertWaiters;       /* the count of insertions which may sleep */
+    char acPad3[MPMCQUEUE_CACHE_LINE - 2 * sizeof(LONG)];
+}MPMCQUEUE;
+
+/*
+ * insert data at tail if there is a free slot
+ * @param MPMCQUEUE *pQueue
+ * @param void *pData
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if the queue is full
+ */
+static INT MpmcQueue_Insert(MPMCQUEUE *pQueue, void *pData)
+{
+    MPMCSLOT *pSlot;
+    UINT uPos = AtomicLoad32(&pQueue->uTail);
+    INT nDiff;
+    for(;;)
+    {
+        pSlot = &pQueue->pSlot[uPos & pQueue->uMask];
+        nDiff = (INT)(AtomicLoad32(&pSlot->uSeq) - uPos);
+        if(0 == nDiff)
+        {
+            if(AtomicCas32(&pQueue->uTail, uPos, uPos + 1))
+                break;
+            uPos = AtomicLoad32(&pQueue->uTail);
+        }
+        else if(nDiff < 0)
+        {
+            /* the slot still holds the data inserted one round before */
+            return CAPI_FAILED;
+        }
+        else
+        {
+            /* the other producer has claimed the position */
+            uPos = AtomicLoad32(&pQueue->uTail);
+        }
+    }
+    pSlot->pData = pData;
+    AtomicStore32(&pSlot->uSeq, uPos + 1);
+    return CAPI_SUCCESS;
+}
+
+/*
+ * pop data at head if there is any data
+ * @param MPMCQUEUE *pQueue
+ * @param void **ppData -- for saving the popped data
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if the queue is empty
+ */
+static INT MpmcQueue_Pop(MPMCQUEUE *pQueue, void **ppData)
+{
+    MPMCSLOT *pSlot;
+    UINT uPos = AtomicLoad32(&pQueue->uHead);
+    INT nDiff;
+    for(;;)
+    {
+        pSlot = &pQueue->pSlot[uPos & pQueue->uMask];
+        nDiff = (INT)(AtomicLoad32(&pSlot->uSeq) - (uPos + 1));
+        if(0 == nDiff)
+        {
+            if(AtomicCas32(&pQueue->uHead, uPos, uPos + 1))
+                break;
+            uPos = AtomicLoad32(&pQueue->uHead);
+        }
+        else if(nDiff < 0)
+        {
+            return CAPI_FAILED;
+        }
+        else
+        {
+            uPos = AtomicLoad32(&pQueue->uHead);
+        }
+    }
+    *ppData = pSlot->pData;
+    AtomicStore32(&pSlot->uSeq, uPos + pQueue->uMask + 1);
+    return CAPI_SUCCESS;
+}
+
+/*
+ * wake a sleeping thread after the slot is changed, the waiter adds itself
+ * before trying again, and we check the waiters after changing the slot, so
+ * one of us must see the other
+ * @param volatile LONG *plWaiters
+ * @param SEMAPHORE pSema
+ * @return void
+ */
+static void MpmcQueue_Wake(volatile LONG *plWaiters, SEMAPHORE pSema)
+{
+    AtomicFence();
+    if((LONG)AtomicLoad32(plWaiters) > 0)
+        (void)SemaRelease(pSema, 1);
+}
+
+/*
+ * create a MPMC queue
+ * @param UINT uCapacity -- the max count of data, it is rounded up to power of 2
+ * @return MPMCQUEUE * if successfully or return NULL if fail
+ */
+MPMCQUEUE *MpmcQueue_Create(UINT uCapacity)
+{
+    MPMCQUEUE *pQueue;
+    UINT uSize = 1;
+    UINT i;
+    if(0 == uCapacity || uCapacity > MPMCQUEUE_MAX_CAPACITY)
+        return NULL;
+    while(uSize < uCapacity)
+        uSize <<= 1;
+    pQueue = (MPMCQUEUE *)malloc(sizeof(MPMCQUEUE));
+    if(NULL == pQueue)
+        return NULL;
+    pQueue->pSlot = (MPMCSLOT *)malloc((size_t)uSize * sizeof(MPMCSLOT));
+    pQueue->pDataSema = SemaCreate(0, MPMCQUEUE_MAX_WAKE);
+    pQueue->pSlotSema = SemaCreate(0, MPMCQUEUE_MAX_WAKE);
+    if(NULL == pQueue->pSlot || NULL == pQueue->pDataSema || NULL == pQueue->pSlotSema)
+    {
+        if(pQueue->pDataSema != NULL)
+            SemaClose(pQueue->pDataSema);
+        if(pQueue->pSlotSema != NULL)
+            SemaClose(pQueue->pSlotSema);
+        free(pQueue->pSlot);
+        free(pQueue);
+        return NULL;
+    }
+    for(i = 0; i < uSize; ++i)
+    {
+        pQueue->pSlot[i].uSeq = i;
+        pQueue->pSlot[i].pData = NULL;
+    }
+    pQueue->uMask = uSize - 1;
+    pQueue->uTail = 0;
+    pQueue->uHead = 0;
+    pQueue->lPopWaiters = 0;
+    pQueue->lInsertWaiters = 0;
+    return pQueue;
+}
+
+/*
+ * destroy MPMC queue and free the data in it, no thread may use it
+ * @param MPMCQUEUE *pQueue
+ * @param DESTROYFUNC DestroyFunc -- the callback function for free data
+ * @return void
+ */
+void MpmcQueue_Destroy(MPMCQUEUE *pQueue, DESTROYFUNC DestroyFunc)
+{
+    void *pData;
+    if(pQueue != NULL)
+    {
+        if(DestroyFunc != NULL)
+        {
+            while(CAPI_SUCCESS == MpmcQueue_Pop(pQueue, &pData))
+            {
+                if(pData != NULL)
+                    (*DestroyFunc)(pData);
+            }
+        }
+        SemaClose(pQueue->pDataSema);
+        SemaClose(pQueue->pSlotSema);
+        free(pQueue->pSlot);
+        free(pQueue);
+    }
+}
+
+/*
+ * insert data to queue's tail without waiting
+ * @param MPMCQUEUE *pQueue
+ * @param void *pData
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if the queue is full
+ */
+INT MpmcQueue_TryInsertTail(MPMCQUEUE *pQueue, void *pData)
+{
+    if(MpmcQueue_Insert(pQueue, pData) != CAPI_SUCCESS)
+        return CAPI_FAILED;
+    MpmcQueue_Wake(&pQueue->lPopWaiters, pQueue->pDataSema);
+    return CAPI_SUCCESS;
+}
+
+/*
+ * pop head's data in queue without waiting
+ * @param MPMCQUEUE *pQueue
+ * @return void * -- return head data or NULL if the queue is empty
+ */
+void *MpmcQueue_TryPopHead(MPMCQUEUE *pQueue)
+{
+    void *pData;
+    if(MpmcQueue_Pop(pQueue, &pData) != CAPI_SUCCESS)
+        return NULL;
+    MpmcQueue_Wake(&pQueue->lInsertWaiters, pQueue->pSlotSema);
+    return pData;
+}
+
+/*
+ * insert data to queue's tail, wait while the queue is full
+ * @param MPMCQUEUE *pQueue
+ * @param void *pData
+ * @return INT -- return CAPI_SUCCESS
+ */
+INT MpmcQueue_InsertTail(MPMCQUEUE *pQueue, void *pData)
+{
+    UINT i;
+    for(;;)
+    {
+        for(i = 0; i < MPMCQUEUE_SPIN; ++i)
+        {
+            if(CAPI_SUCCESS == MpmcQueue_TryInsertTail(pQueue, pData))
+                return CAPI_SUCCESS;
+            if(i >= MPMCQUEUE_SPIN / 2)
+                ThreadYield();
+        }
+        (void)AtomicIncrement(&pQueue->lInsertWaiters);
+        if(CAPI_SUCCESS == MpmcQueue_TryInsertTail(pQueue, pData))
+        {
+            (void)AtomicDecrement(&pQueue->lInsertWaiters);
+            return CAPI_SUCCESS;
+        }
+        (void)SemaWait(pQueue->pSlotSema);
+        (void)AtomicDecrement(&pQueue->lInsertWaiters);
+    }
+}
+
+/*
+ * pop head's data in queue, wait while the queue is empty
+ * @param MPMCQUEUE *pQueue
+ * @return void * -- return head data, and it can be NULL if NULL is inserted
+ */
+void *MpmcQueue_PopHead(MPMCQUEUE *pQueue)
+{
+    void *pData;
+    UINT i;
+    for(;;)
+    {
+        for(i = 0; i < MPMCQUEUE_SPIN; ++i)
+        {
+            if(CAPI_SUCCESS == MpmcQueue_Pop(pQueue, &pData))
+                goto END;
+            if(i >= MPMCQUEUE_SPIN / 2)
+                ThreadYield();
+        }
+        (void)AtomicIncrement(&pQueue->lPopWaiters);
+        if(CAPI_SUCCESS == MpmcQueue_Pop(pQueue, &pData))
+        {
+            (void)AtomicDecrement(&pQueue->lPopWaiters);
+            goto END;
+        }
+        (void)SemaWait(pQueue->pDataSema);
+        (void)AtomicDecrement(&pQueue->lPopWaiters);
+    }
+END:
+    MpmcQueue_Wake(&pQueue->lInsertWaiters, pQueue->pSlotSema);
+    return pData;
+}
+
+/*
+ * get the count of data in queue, it may be changed by others at once
+ * @param MPMCQUEUE *pQueue
+ * @return UINT
+ */
+UINT MpmcQueue_GetCount(MPMCQUEUE *pQueue)
+{
+    UINT uHead = AtomicLoad32(&pQueue->uHead);
+    UINT uTail = AtomicLoad32(&pQueue->uTail);
+    return (INT)(uTail - uHead) > 0 ? uTail - uHead : 0;
+}
@@ -5,6 +5,7 @@
  * Description: Queue program
 **********************************************************************************/
 
+#pragma once
 #include "algo.h"
 
 typedef struct QUEUE_st{
@@ -14,6 +15,56 @@ typedef struct QUEUE_st{
     UINT uTail;
 }QUEUE;
 
+/*
+ * create a queue
+ * @param UINT uMaxCount -- the initial size, the queue doubles size when full
+ * @return QUEUE * if successfully or return NULL if fail
+ */
+QUEUE *Queue_Create(UINT uMaxCount)
+{
+    QUEUE *pQueue;
+    if(uMaxCount < 2)
+        return NULL;
+    pQueue = (QUEUE *)malloc(sizeof(QUEUE));
+    if(pQueue != NULL)
+    {
+        pQueue->ppData = (void **)malloc(uMaxCount * sizeof(void *));
+        if(NULL == pQueue->ppData)
+        {
+            free(pQueue);
+            return NULL;
+        }
+        pQueue->uMaxCount = uMaxCount;
+        pQueue->uHead = 0;
+        pQueue->uTail = 0;
+    }
+    return pQueue;
+}
+
+/*
+ * destroy queue and free the data in it
+ * @param QUEUE *pQueue
+ * @param DESTROYFUNC DestroyFunc -- the callback function for free data
+ * @return void
+ */
+void Queue_Destroy(QUEUE *pQueue, DESTROYFUNC DestroyFunc)
+{
+    UINT uHead;
+    if(pQueue != NULL)
+    {
+        if(DestroyFunc != NULL)
+        {
+            for(uHead = pQueue->uHead; uHead != pQueue->uTail; uHead = (uHead + 1) % pQueue->uMaxCount)
+            {
+                if(pQueue->ppData[uHead] != NULL)
+                    (*DestroyFunc)(pQueue->ppData[uHead]);
+            }
+        }
+        free(pQueue->ppData);
+        free(pQueue);
+    }
+}
+
 /*
  * insert data to queue's tail, double size if queue is full
  * @param QUEUE *pQueue
@@ -0,0 +1,205 @@
+/*********************************************************************************
+ * FileName:	spscQueue.c
+ * Author:		gehan
+ * Date:		07/23/2017
+ * Description: Lock-free bounded queue program for one producer thread and one
+ *				consumer thread, the capacity is power of 2 so the index is masked
+ *				instead of wrapped. The head and tail are on separate cache lines,
+ *				and each side keeps a copy of the other side's index, so it only
+ *				reads the other cache line when the copy says full or empty
+**********************************************************************************/
+
+#pragma once
+#include <string.h>
+#include "algo.h"
+
+#define SPSCQUEUE_CACHE_LINE    64
+#define SPSCQUEUE_MAX_CAPACITY  0x80000000u
+
+/*
+ * the head and tail increase without wrapping, tail - head is the count of data
+ */
+typedef struct SPSCQUEUE_st{
+    void **ppData;
+    UINT uMask;                 /* the capacity - 1 */
+    char acPad0[SPSCQUEUE_CACHE_LINE - sizeof(void **) - sizeof(UINT)];
+    volatile UINT uHead;        /* only the consumer changes it */
+    UINT uTailCache;            /* the tail seen by consumer */
+    char acPad1[SPSCQUEUE_CACHE_LINE - 2 * sizeof(UINT)];
+    volatile UINT uTail;        /* only the producer changes it */
+    UINT uHeadCache;            /* the head seen by producer */
+    char acPad2[SPSCQUEUE_CACHE_LINE - 2 * sizeof(UINT)];
+}SPSCQUEUE;
+
+/*
+ * create a SPSC queue
+ * @param UINT uCapacity -- the max count of data, it is rounded up to power of 2
+ * @return SPSCQUEUE * if successfully or return NULL if fail
+ */
+SPSCQUEUE *SpscQueue_Create(UINT uCapacity)
+{
+    SPSCQUEUE *pQueue;
+    UINT uSize = 1;
+    if(0 == uCapacity || uCapacity > SPSCQUEUE_MAX_CAPACITY)
+        return NULL;
+    while(uSize < uCapacity)
+        uSize <<= 1;
+    pQueue = (SPSCQUEUE *)malloc(sizeof(SPSCQUEUE));
+    if(pQueue != NULL)
+    {
+        pQueue->ppData = (void **)malloc((size_t)uSize * sizeof(void *));
+        if(NULL == pQueue->ppData)
+        {
+            free(pQueue);
+            return NULL;
+        }
+        pQueue->uMask = uSize - 1;
+        pQueue->uHead = 0;
+        pQueue->uTailCache = 0;
+        pQueue->uTail = 0;
+        pQueue->uHeadCache = 0;
+    }
+    return pQueue;
+}
+
+/*
+ * destroy SPSC queue and free the data in it, no thread may use it
+ * @param SPSCQUEUE *pQueue
+ * @param DESTROYFUNC DestroyFunc -- the callback function for free data
+ * @return void
+ */
+void SpscQueue_Destroy(SPSCQUEUE *pQueue, DESTROYFUNC DestroyFunc)
+{
+    UINT uHead;
+    if(pQueue != NULL)
+    {
+        if(DestroyFunc != NULL)
+        {
+            for(uHead = pQueue->uHead; uHead != pQueue->uTail; ++uHead)
+            {
+                if(pQueue->ppData[uHead & pQueue->uMask] != NULL)
+                    (*DestroyFunc)(pQueue->ppData[uHead & pQueue->uMask]);
+            }
+        }
+        free(pQueue->ppData);
+        free(pQueue);
+    }
+}
+
+/*
+ * insert data to queue's tail, it is only called by the producer
+ * @param SPSCQUEUE *pQueue
+ * @param void *pData -- it should not be NULL, or it can't be told from empty
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED if the queue is full
+ */
+INT SpscQueue_InsertTail(SPSCQUEUE *pQueue, void *pData)
+{
+    UINT uTail = pQueue->uTail;
+    if(uTail - pQueue->uHeadCache > pQueue->uMask)
+    {
+        pQueue->uHeadCache = AtomicLoad32(&pQueue->uHead);
+        if(uTail - pQueue->uHeadCache > pQueue->uMask)
+            return CAPI_FAILED;
+    }
+    pQueue->ppData[uTail & pQueue->uMask] = pData;
+    /* the data must be written before the consumer sees the new tail */
+    AtomicStore32(&pQueue->uTail, uTail + 1);
+    return CAPI_SUCCESS;
+}
+
+/*
+ * pop head's data in queue, it is only called by the consumer
+ * @param SPSCQUEUE *pQueue
+ * @return void * -- return head data or NULL if the queue is empty
+ */
+void *SpscQueue_PopHead(SPSCQUEUE *pQueue)
+{
+    UINT uHead = pQueue->uHead;
+    void *pData;
+    if(uHead == pQueue->uTailCache)
+    {
+        pQueue->uTailCache = AtomicLoad32(&pQueue->uTail);
+        if(uHead == pQueue->uTailCache)
+            return NULL;
+    }
+    pData = pQueue->ppData[uHead & pQueue->uMask];
+    /* the data must be read before the producer sees the slot is free */
+    AtomicStore32(&pQueue->uHead, uHead + 1);
+    return pData;
+}
+
+/*
+ * insert some data to queue's tail as many as possible, the consumer sees them
+ * all at once, it is only called by the producer
+ * @param SPSCQUEUE *pQueue
+ * @param void **ppData -- the array of data
+ * @param UINT uCount -- the count of data in array
+ * @return UINT -- the count of inserted data, 0 if the queue is full
+ */
+UINT SpscQueue_InsertBatch(SPSCQUEUE *pQueue, void **ppData, UINT uCount)
+{
+    UINT uTail = pQueue->uTail;
+    UINT uFree = pQueue->uMask + 1 - (uTail - pQueue->uHeadCache);
+    UINT uPos, uFirst;
+    if(uFree < uCount)
+    {
+        pQueue->uHeadCache = AtomicLoad32(&pQueue->uHead);
+        uFree = pQueue->uMask + 1 - (uTail - pQueue->uHeadCache);
+        if(uFree < uCount)
+            uCount = uFree;
+    }
+    if(0 == uCount)
+        return 0;
+    /* copy in two parts if it wraps around the array's end */
+    uPos = uTail & pQueue->uMask;
+    uFirst = pQueue->uMask + 1 - uPos;
+    if(uFirst > uCount)
+        uFirst = uCount;
+    memcpy(&pQueue->ppData[uPos], ppData, uFirst * sizeof(void *));
+    memcpy(pQueue->ppData, ppData + uFirst, (uCount - uFirst) * sizeof(void *));
+    AtomicStore32(&pQueue->uTail, uTail + uCount);
+    return uCount;
+}
+
+/*
+ * pop some data from queue's head as many as possible, the producer gets all
+ * the slots at once, it is only called by the consumer
+ * @param SPSCQUEUE *pQueue
+ * @param void **ppData -- the array for saving popped data
+ * @param UINT uCount -- the size of array
+ * @return UINT -- the count of popped data, 0 if the queue is empty
+ */
+UINT SpscQueue_PopBatch(SPSCQUEUE *pQueue, void **ppData, UINT uCount)
+{
+    UINT uHead = pQueue->uHead;
+    UINT uUsed = pQueue->uTailCache - uHead;
+    UINT uPos, uFirst;
+    if(uUsed < uCount)
+    {
+        pQueue->uTailCache = AtomicLoad32(&pQueue->uTail);
+        uUsed = pQueue->uTailCache - uHead;
+        if(uUsed < uCount)
+            uCount = uUsed;
+    }
+    if(0 == uCount)
+        return 0;
+    uPos = uHead & pQueue->uMask;
+    uFirst = pQueue->uMask + 1 - uPos;
+    if(uFirst > uCount)
+        uFirst = uCount;
+    memcpy(ppData, &pQueue->ppData[uPos], uFirst * sizeof(void *));
+    memcpy(ppData + uFirst, pQueue->ppData, (uCount - uFirst) * sizeof(void *));
+    AtomicStore32(&pQueue->uHead, uHead + uCount);
+    return uCount;
+}
+
+/*
+ * get the count of data in queue, it may be changed by the other side at once
+ * @param SPSCQUEUE *pQueue
+ * @return UINT
+ */
+UINT SpscQueue_GetCount(SPSCQUEUE *pQueue)
+{
+    UINT uHead = AtomicLoad32(&pQueue->uHead);
+    return AtomicLoad32(&pQueue->uTail) - uHead;
+}
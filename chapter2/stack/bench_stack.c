@@ -0,0 +1,241 @@
+/*********************************************************************************
+ * FileName:	bench_stack.c
+ * Author:		gehan
+ * Date:		07/21/2017
+ * Description: Contention benchmark of the concurrent stacks, each thread pushes
+ *				and pops in pairs like an object pool, and the total throughput
+ *				is written as JSON for 1, 2, 4 ... max threads.
+ *				build:	cc -O2 -I../.. bench_stack.c -o bench_stack (add -pthread on Linux)
+ *				usage:	bench_stack [-t max_threads] [-n pairs_per_thread] [-o file.json]
+**********************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include "algo.h"
+#include "mstack.c"
+#include "lockFreeStack.c"
+#include "eliminationStack.c"
+
+typedef struct BENCHSTACK_st{
+    const char *pszName;
+    void *(*CreateFunc)(void);
+    void (*DestroyFunc)(void *pStack);
+    INT (*PushFunc)(void *pStack, void *pData);
+    void *(*PopFunc)(void *pStack);
+}BENCHSTACK;
+
+/*
+ * the argument of benchmark thread
+ */
+typedef struct BENCHWORKER_st{
+    BENCHSTACK *pKind;
+    void *pStack;
+    UINT uPairCount;
+    volatile LONG *plReady;     /* the count of threads which are ready */
+    volatile LONG *plStart;     /* it becomes nonzero when all threads are ready */
+}BENCHWORKER;
+
+static double Bench_Now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER Counter, Frequency;
+    QueryPerformanceCounter(&Counter);
+    QueryPerformanceFrequency(&Frequency);
+    return (double)Counter.QuadPart / (double)Frequency.QuadPart;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (double)Time.tv_sec + (double)Time.tv_nsec * 1e-9;
+#endif
+}
+
+static void *Bench_MutexCreate(void)
+{
+    return MSTACK_Create(1024);
+}
+
+static void Bench_MutexDestroy(void *pStack)
+{
+    MStack_Destroy((MSTACK *)pStack, NULL);
+}
+
+static INT Bench_MutexPush(void *pStack, void *pData)
+{
+    return MStack_Push((MSTACK *)pStack, pData);
+}
+
+static void *Bench_MutexPop(void *pStack)
+{
+    return MStack_Pop((MSTACK *)pStack);
+}
+
+static void *Bench_LFCreate(void)
+{
+    return LFStack_Create(1024);
+}
+
+static void Bench_LFDestroy(void *pStack)
+{
+    LFStack_Destroy((LFSTACK *)pStack, NULL);
+}
+
+static INT Bench_LFPush(void *pStack, void *pData)
+{
+    return LFStack_Push((LFSTACK *)pStack, pData);
+}
+
+static void *Bench_LFPop(void *pStack)
+{
+    return LFStack_Pop((LFSTACK *)pStack);
+}
+
+static void *Bench_ElimCreate(void)
+{
+    return ElimStack_Create(1024);
+}
+
+static void Bench_ElimDestroy(void *pStack)
+{
+    ElimStack_Destroy((ELIMSTACK *)pStack, NULL);
+}
+
+static INT Bench_ElimPush(void *pStack, void *pData)
+{
+    return ElimStack_Push((ELIMSTACK *)pStack, pData);
+}
+
+static void *Bench_ElimPop(void *pStack)
+{
+    return ElimStack_Pop((ELIMSTACK *)pStack);
+}
+
+static BENCHSTACK g_aKind[] = {
+    { "mutex", Bench_MutexCreate, Bench_MutexDestroy, Bench_MutexPush, Bench_MutexPop },
+    { "lock_free", Bench_LFCreate, Bench_LFDestroy, Bench_LFPush, Bench_LFPop },
+    { "elimination", Bench_ElimCreate, Bench_ElimDestroy, Bench_ElimPush, Bench_ElimPop },
+};
+
+#define BENCH_COUNT_OF(a)   (sizeof(a) / sizeof((a)[0]))
+
+/*
+ * the thread function of benchmark, it waits until all threads are ready
+ * @param void *pArg -- the BENCHWORKER pointer
+ * @return THREADRET
+ */
+static THREADRET THREADAPI Bench_Worker(void *pArg)
+{
+    BENCHWORKER *pWorker = (BENCHWORKER *)pArg;
+    BENCHSTACK *pKind = pWorker->pKind;
+    UINT i;
+    (void)AtomicIncrement(pWorker->plReady);
+    while(0 == *pWorker->plStart)
+        ThreadYield();
+    for(i = 0; i < pWorker->uPairCount; ++i)
+    {
+        (void)(*pKind->PushFunc)(pWorker->pStack, pWorker);
+        (void)(*pKind->PopFunc)(pWorker->pStack);
+    }
+    return 0;
+}
+
+/*
+ * run a stack with some threads
+ * @return double -- the million operations per second, negative if failed
+ */
+static double Bench_Run(BENCHSTACK *pKind, UINT uThreadCount, UINT uPairCount)
+{
+    BENCHWORKER *pWorker = (BENCHWORKER *)malloc(uThreadCount * sizeof(BENCHWORKER));
+    THREAD *pThread = (THREAD *)malloc(uThreadCount * sizeof(THREAD));
+    void *pStack = (*pKind->CreateFunc)();
+    volatile LONG lReady = 0, lStart = 0;
+    double dStart, dTime = -1.0;
+    UINT uCreated;
+    UINT i;
+    if(NULL == pWorker || NULL == pThread || NULL == pStack)
+        goto END;
+    for(uCreated = 0; uCreated < uThreadCount; ++uCreated)
+    {
+        pWorker[uCreated].pKind = pKind;
+        pWorker[uCreated].pStack = pStack;
+        pWorker[uCreated].uPairCount = uPairCount;
+        pWorker[uCreated].plReady = &lReady;
+        pWorker[uCreated].plStart = &lStart;
+        pThread[uCreated] = ThreadCreate(Bench_Worker, &pWorker[uCreated]);
+        if(NULL == pThread[uCreated])
+            break;
+    }
+    /* the created threads must be started even if failed, or they wait forever */
+    while(lReady != (LONG)uCreated)
+        ThreadYield();
+    dStart = Bench_Now();
+    (void)AtomicIncrement(&lStart);
+    for(i = 0; i < uCreated; ++i)
+    {
+        ThreadJoin(pThread[i]);
+        ThreadClose(pThread[i]);
+    }
+    dTime = Bench_Now() - dStart;
+    if(uCreated == uThreadCount && dTime > 0)
+        dTime = 2.0 * uPairCount * uThreadCount / dTime * 1e-6;
+    else
+        dTime = -1.0;
+END:
+    if(pStack != NULL)
+        (*pKind->DestroyFunc)(pStack);
+    free(pThread);
+    free(pWorker);
+    return dTime;
+}
+
+int main(int argc, char *argv[])
+{
+    UINT uMaxThread = 64;
+    UINT uPairCount = 100000;
+    const char *pszOutput = NULL;
+    FILE *pOut = stdout;
+    INT bFirst = 1;
+    UINT k, t;
+    INT n;
+
+    for(n = 1; n + 1 < argc; n += 2)
+    {
+        if(0 == strcmp(argv[n], "-t"))
+            uMaxThread = (UINT)strtoul(argv[n + 1], NULL, 10);
+        else if(0 == strcmp(argv[n], "-n"))
+            uPairCount = (UINT)strtoul(argv[n + 1], NULL, 10);
+        else if(0 == strcmp(argv[n], "-o"))
+            pszOutput = argv[n + 1];
+        else
+            break;
+    }
+    if(n < argc || 0 == uMaxThread || 0 == uPairCount)
+    {
+        fprintf(stderr, "usage: %s [-t max_threads] [-n pairs_per_thread] [-o file.json]\n", argv[0]);
+        return 1;
+    }
+    if(NULL != pszOutput)
+    {
+        pOut = fopen(pszOutput, "w");
+        if(NULL == pOut)
+        {
+            fprintf(stderr, "can't open %s\n", pszOutput);
+            return 1;
+        }
+    }
+
+    fprintf(pOut, "{\n  \"pairs_per_thread\": %u,\n  \"results\": [", uPairCount);
+    for(k = 0; k < BENCH_COUNT_OF(g_aKind); ++k)
+    {
+        for(t = 1; t <= uMaxThread; t *= 2)
+        {
+            fprintf(pOut, "%s\n    {\"stack\": \"%s\", \"threads\": %u, \"mops\": %.3f}",
+                bFirst ? "" : ",", g_aKind[k].pszName, t, Bench_Run(&g_aKind[k], t, uPairCount));
+            bFirst = 0;
+            fflush(pOut);
+        }
+    }
+    fprintf(pOut, "\n  ]\n}\n");
+    if(stdout != pOut)
+        fclose(pOut);
+    return 0;
+}
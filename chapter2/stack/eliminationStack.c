@@ -0,0 +1,236 @@
+/*********************************************************************************
+ * FileName:	eliminationStack.c
+ * Author:		gehan
+ * Date:		07/21/2017
+ * Description: Elimination-backoff stack program, when the CAS on the top of
+ *				lock-free stack fails, the push offers its node in a slot of the
+ *				elimination array and the pop takes a node from a slot, so the
+ *				push and pop pairs cancel each other without touching the top.
+ *				The count of used slots grows on collision and shrinks on timeout
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+#include "lockFreeStack.c"
+
+#define ELIMSTACK_SLOT_COUNT    16      /* the max count of used slots */
+#define ELIMSTACK_SPIN          128     /* the times of checking the offer */
+
+/*
+ * the slot of elimination array, it holds (tag << 32) | index of the offered node
+ * or LFSTACK_NULL, each slot has its own cache line
+ */
+typedef struct ELIMSLOT_st{
+    volatile UINT64 uValue;
+    char acPad[LFSTACK_CACHE_LINE - sizeof(UINT64)];
+}ELIMSLOT;
+
+typedef struct ELIMSTACK_st{
+    LFSTACK *pStack;
+    ELIMSLOT aSlot[ELIMSTACK_SLOT_COUNT];
+    volatile UINT uRange;       /* the count of used slots, it is a hint */
+}ELIMSTACK;
+
+/*
+ * choose a slot in the used range, the address of a local variable differs
+ * between threads so they spread over the slots
+ * @param ELIMSTACK *pElim
+ * @param UINT uSeed
+ * @return ELIMSLOT *
+ */
+static ELIMSLOT *ElimStack_ChooseSlot(ELIMSTACK *pElim, UINT uSeed)
+{
+    UINT uHash = (UINT)((size_t)&uSeed >> 4) * 2654435761u + uSeed * 40503u;
+    return &pElim->aSlot[(uHash >> 16) % pElim->uRange];
+}
+
+/*
+ * change the count of used slots, the race of changing is harmless
+ * @param ELIMSTACK *pElim
+ * @param INT bGrow
+ * @return void
+ */
+static void ElimStack_Adapt(ELIMSTACK *pElim, INT bGrow)
+{
+    UINT uRange = pElim->uRange;
+    if(bGrow && uRange < ELIMSTACK_SLOT_COUNT)
+        pElim->uRange = uRange + 1;
+    else if(!bGrow && uRange > 1)
+        pElim->uRange = uRange - 1;
+}
+
+/*
+ * offer a node in a slot and wait for a pop to take it
+ * @param ELIMSTACK *pElim
+ * @param UINT uIndex -- the index of node
+ * @param UINT uSeed
+ * @return INT -- 1 if the node is taken by a pop, 0 if it is not
+ */
+static INT ElimStack_Offer(ELIMSTACK *pElim, UINT uIndex, UINT uSeed)
+{
+    ELIMSLOT *pSlot = ElimStack_ChooseSlot(pElim, uSeed);
+    UINT64 uValue, uOffer;
+    UINT i;
+    uValue = AtomicLoad64(&pSlot->uValue);
+    if(LFSTACK_INDEX(uValue) != LFSTACK_NULL || !AtomicCas64(&pSlot->uValue, uValue, LFSTACK_HEAD(uValue, uIndex)))
+    {
+        /* the slot is used by others, so spread over more slots */
+        ElimStack_Adapt(pElim, 1);
+        return 0;
+    }
+    uOffer = LFSTACK_HEAD(uValue, uIndex);
+    for(i = 0; i < ELIMSTACK_SPIN; ++i)
+    {
+        if(AtomicLoad64(&pSlot->uValue) != uOffer)
+            return 1;
+    }
+    /* withdraw the offer, it fails only if a pop has taken it */
+    if(AtomicCas64(&pSlot->uValue, uOffer, LFSTACK_HEAD(uOffer, LFSTACK_NULL)))
+    {
+        ElimStack_Adapt(pElim, 0);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * take a node offered by a push
+ * @param ELIMSTACK *pElim
+ * @param UINT uSeed
+ * @return UINT -- the index of node, LFSTACK_NULL if no node is taken
+ */
+static UINT ElimStack_Take(ELIMSTACK *pElim, UINT uSeed)
+{
+    ELIMSLOT *pSlot = ElimStack_ChooseSlot(pElim, uSeed);
+    UINT64 uValue = AtomicLoad64(&pSlot->uValue);
+    UINT uIndex = LFSTACK_INDEX(uValue);
+    if(LFSTACK_NULL == uIndex || !AtomicCas64(&pSlot->uValue, uValue, LFSTACK_HEAD(uValue, LFSTACK_NULL)))
+        return LFSTACK_NULL;
+    return uIndex;
+}
+
+/*
+ * create an elimination-backoff stack
+ * @param UINT uStackSize -- the count of nodes allocated at first
+ * @return ELIMSTACK * if successfully or return NULL if fail
+ */
+ELIMSTACK *ElimStack_Create(UINT uStackSize)
+{
+    ELIMSTACK *pElim;
+    UINT i;
+    pElim = (ELIMSTACK *)malloc(sizeof(ELIMSTACK));
+    if(pElim != NULL)
+    {
+        pElim->pStack = LFStack_Create(uStackSize);
+        if(pElim->pStack == NULL)
+        {
+            free(pElim);
+            return NULL;
+        }
+        for(i = 0; i < ELIMSTACK_SLOT_COUNT; ++i)
+            pElim->aSlot[i].uValue = LFSTACK_NULL;
+        pElim->uRange = 1;
+    }
+    return pElim;
+}
+
+/*
+ * destroy elimination-backoff stack and free all data, no thread may use it
+ * @param ELIMSTACK *pElim
+ * @param DESTROYFUNC DestroyFunc -- the callback function for free data
+ * @return void
+ */
+void ElimStack_Destroy(ELIMSTACK *pElim, DESTROYFUNC DestroyFunc)
+{
+    if(pElim != NULL)
+    {
+        LFStack_Destroy(pElim->pStack, DestroyFunc);
+        free(pElim);
+    }
+}
+
+/*
+ * push data into elimination-backoff stack, and the data can be NULL
+ * @param ELIMSTACK *pElim
+ * @param void *pData
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT ElimStack_Push(ELIMSTACK *pElim, void *pData)
+{
+    LFSTACK *pStack;
+    LFSTACKNODE *pNode;
+    UINT64 uHead;
+    UINT uIndex;
+    UINT uTry;
+    if(NULL == pElim)
+        return CAPI_FAILED;
+    pStack = pElim->pStack;
+    uIndex = LFStack_PopNode(pStack, &pStack->uFreeHead);
+    while(LFSTACK_NULL == uIndex)
+    {
+        if(LFStack_AddChunk(pStack) != CAPI_SUCCESS)
+            return CAPI_FAILED;
+        uIndex = LFStack_PopNode(pStack, &pStack->uFreeHead);
+    }
+    pNode = LFStack_GetNode(pStack, uIndex);
+    pNode->pData = pData;
+    for(uTry = 0; ; ++uTry)
+    {
+        uHead = AtomicLoad64(&pStack->uHead);
+        pNode->uNext = LFSTACK_INDEX(uHead);
+        if(AtomicCas64(&pStack->uHead, uHead, LFSTACK_HEAD(uHead, uIndex)))
+            return CAPI_SUCCESS;
+        if(ElimStack_Offer(pElim, uIndex, uTry))
+            return CAPI_SUCCESS;
+    }
+}
+
+/*
+ * pop top data in elimination-backoff stack
+ * @param ELIMSTACK *pElim
+ * @return void * -- return top stack data successfully or return NULL
+ */
+void *ElimStack_Pop(ELIMSTACK *pElim)
+{
+    LFSTACK *pStack;
+    LFSTACKNODE *pNode;
+    void *pData;
+    UINT64 uHead;
+    UINT uIndex;
+    UINT uTry;
+    if(NULL == pElim)
+        return NULL;
+    pStack = pElim->pStack;
+    for(uTry = 0; ; ++uTry)
+    {
+        uHead = AtomicLoad64(&pStack->uHead);
+        uIndex = LFSTACK_INDEX(uHead);
+        if(LFSTACK_NULL == uIndex)
+        {
+            /* a concurrent push may be waiting in a slot */
+            uIndex = ElimStack_Take(pElim, uTry);
+            if(LFSTACK_NULL == uIndex)
+                return NULL;
+            break;
+        }
+        if(AtomicCas64(&pStack->uHead, uHead, LFSTACK_HEAD(uHead, LFStack_GetNode(pStack, uIndex)->uNext)))
+            break;
+        uIndex = ElimStack_Take(pElim, uTry);
+        if(uIndex != LFSTACK_NULL)
+            break;
+    }
+    pNode = LFStack_GetNode(pStack, uIndex);
+    pData = pNode->pData;
+    LFStack_PushNode(&pStack->uFreeHead, uIndex, pNode);
+    return pData;
+}
+
+/*
+ * check stack is empty or not, the offered nodes are not counted
+ * @param ELIMSTACK *pElim
+ * @return INT -- 0 means empty, 1 means non-empty
+ */
+INT ElimStack_IsEmpty(ELIMSTACK *pElim)
+{
+    return LFStack_IsEmpty(pElim->pStack);
+}
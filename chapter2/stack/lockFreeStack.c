@@ -0,0 +1,264 @@
+/*********************************************************************************
+ * FileName:	lockFreeStack.c
+ * Author:		gehan
+ * Date:		07/20/2017
+ * Description: Lock-free stack program (Treiber stack), the nodes are kept in
+ *				chunks and referenced by index, the head holds a tag beside the
+ *				index so that the CAS fails if the node was popped and pushed
+ *				again (ABA). The popped nodes are recycled in a free list, so
+ *				push and pop never call malloc except the nodes are used up
+**********************************************************************************/
+
+#pragma once
+#include "algo.h"
+
+#define LFSTACK_NULL        0xFFFFFFFF  /* the index of no node */
+#define LFSTACK_MAX_CHUNK   24          /* the chunks double size, so it is enough */
+#define LFSTACK_CACHE_LINE  64
+
+/* the head is (tag << 32) | index, the tag increases on each change */
+#define LFSTACK_INDEX(uHead)        ((UINT)(uHead))
+#define LFSTACK_HEAD(uHead, uIndex) ((((uHead) >> 32) + 1) << 32 | (UINT64)(uIndex))
+
+typedef struct LFSTACKNODE_st{
+    void *pData;
+    volatile UINT uNext;
+}LFSTACKNODE;
+
+typedef struct LFSTACK_st{
+    volatile UINT64 uHead;      /* the top of stack */
+    char acPad1[LFSTACK_CACHE_LINE - sizeof(UINT64)];
+    volatile UINT64 uFreeHead;  /* the top of free nodes */
+    char acPad2[LFSTACK_CACHE_LINE - sizeof(UINT64)];
+    LFSTACKNODE *volatile apChunk[LFSTACK_MAX_CHUNK];
+    volatile UINT uChunkCount;
+    UINT uLogFirst;             /* the first chunk has (1 << uLogFirst) nodes */
+    LOCK pLock;                 /* it is only locked when adding chunk */
+}LFSTACK;
+
+/*
+ * get the node by index, the chunk k (k > 0) starts from (1 << (uLogFirst + k - 1))
+ * @param LFSTACK *pStack
+ * @param UINT uIndex
+ * @return LFSTACKNODE *
+ */
+static LFSTACKNODE *LFStack_GetNode(LFSTACK *pStack, UINT uIndex)
+{
+    UINT uHigh = uIndex >> pStack->uLogFirst;
+    UINT uChunk = 0;
+    while(uHigh != 0)
+    {
+        ++uChunk;
+        uHigh >>= 1;
+    }
+    if(0 == uChunk)
+        return &pStack->apChunk[0][uIndex];
+    return &pStack->apChunk[uChunk][uIndex - (1u << (pStack->uLogFirst + uChunk - 1))];
+}
+
+/*
+ * push a node into a list by CAS
+ * @param volatile UINT64 *puHead -- the head of list
+ * @param UINT uFirst -- the first node of nodes to push
+ * @param LFSTACKNODE *pLast -- the last node of nodes to push
+ * @return void
+ */
+static void LFStack_PushNode(volatile UINT64 *puHead, UINT uFirst, LFSTACKNODE *pLast)
+{
+    UINT64 uHead;
+    do
+    {
+        uHead = AtomicLoad64(puHead);
+        pLast->uNext = LFSTACK_INDEX(uHead);
+    }while(!AtomicCas64(puHead, uHead, LFSTACK_HEAD(uHead, uFirst)));
+}
+
+/*
+ * pop a node from a list by CAS, the next index read from a node which is
+ * popped by others is stale, but the tag of head makes the CAS fail then
+ * @param LFSTACK *pStack
+ * @param volatile UINT64 *puHead -- the head of list
+ * @return UINT -- the index of node, LFSTACK_NULL if the list is empty
+ */
+static UINT LFStack_PopNode(LFSTACK *pStack, volatile UINT64 *puHead)
+{
+    UINT64 uHead;
+    UINT uIndex;
+    do
+    {
+        uHead = AtomicLoad64(puHead);
+        uIndex = LFSTACK_INDEX(uHead);
+        if(LFSTACK_NULL == uIndex)
+            return LFSTACK_NULL;
+    }while(!AtomicCas64(puHead, uHead, LFSTACK_HEAD(uHead, LFStack_GetNode(pStack, uIndex)->uNext)));
+    return uIndex;
+}
+
+/*
+ * add a chunk of nodes into free list, the chunk has the same count of
+ * nodes as all chunks before it
+ * @param LFSTACK *pStack
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+static INT LFStack_AddChunk(LFSTACK *pStack)
+{
+    LFSTACKNODE *pChunk;
+    UINT uChunk, uStart, uCount;
+    UINT i;
+    INT nRet = CAPI_SUCCESS;
+    Lock(pStack->pLock);
+    /* the other thread may have added a chunk */
+    uChunk = pStack->uChunkCount;
+    if(LFSTACK_INDEX(AtomicLoad64(&pStack->uFreeHead)) == LFSTACK_NULL)
+    {
+        uStart = 0 == uChunk ? 0 : 1u << (pStack->uLogFirst + uChunk - 1);
+        uCount = 0 == uChunk ? 1u << pStack->uLogFirst : uStart;
+        /* the index must be less than 1 << 31, so it never reaches LFSTACK_NULL */
+        if(uChunk == LFSTACK_MAX_CHUNK || pStack->uLogFirst + uChunk > 31)
+        {
+            nRet = CAPI_FAILED;
+        }
+        else if(NULL == (pChunk = (LFSTACKNODE *)malloc((size_t)uCount * sizeof(LFSTACKNODE))))
+        {
+            nRet = CAPI_FAILED;
+        }
+        else
+        {
+            for(i = 0; i + 1 < uCount; ++i)
+            {
+                pChunk[i].pData = NULL;
+                pChunk[i].uNext = uStart + i + 1;
+            }
+            pChunk[uCount - 1].pData = NULL;
+            /* the chunk must be seen before its nodes are popped */
+            pStack->apChunk[uChunk] = pChunk;
+            pStack->uChunkCount = uChunk + 1;
+            LFStack_PushNode(&pStack->uFreeHead, uStart, &pChunk[uCount - 1]);
+        }
+    }
+    Unlock(pStack->pLock);
+    return nRet;
+}
+
+/*
+ * create a lock-free stack
+ * @param UINT uStackSize -- the count of nodes allocated at first, the stack
+ *                           grows when they are used up
+ * @return LFSTACK * if successfully or return NULL if fail
+ */
+LFSTACK *LFStack_Create(UINT uStackSize)
+{
+    LFSTACK *pStack;
+    if(uStackSize == 0)
+        return NULL;
+    pStack = (LFSTACK *)malloc(sizeof(LFSTACK));
+    if(pStack != NULL)
+    {
+        pStack->uHead = LFSTACK_NULL;
+        pStack->uFreeHead = LFSTACK_NULL;
+        pStack->uChunkCount = 0;
+        pStack->uLogFirst = 0;
+        while(pStack->uLogFirst < 24 && (1u << pStack->uLogFirst) < uStackSize)
+            pStack->uLogFirst += 1;
+        pStack->pLock = LockCreate();
+        if(pStack->pLock == NULL)
+        {
+            free(pStack);
+            return NULL;
+        }
+        if(LFStack_AddChunk(pStack) != CAPI_SUCCESS)
+        {
+            LockClose(pStack->pLock);
+            free(pStack);
+            return NULL;
+        }
+    }
+    return pStack;
+}
+
+/*
+ * destroy lock-free stack and free all data, no thread may use it
+ * @param LFSTACK *pStack
+ * @param DESTROYFUNC DestroyFunc -- the callback function for free data
+ * @return void
+ */
+void LFStack_Destroy(LFSTACK *pStack, DESTROYFUNC DestroyFunc)
+{
+    LFSTACKNODE *pNode;
+    UINT uIndex;
+    UINT i;
+    if(pStack != NULL)
+    {
+        if(DestroyFunc != NULL)
+        {
+            uIndex = LFSTACK_INDEX(pStack->uHead);
+            while(uIndex != LFSTACK_NULL)
+            {
+                pNode = LFStack_GetNode(pStack, uIndex);
+                if(pNode->pData != NULL)
+                    (*DestroyFunc)(pNode->pData);
+                uIndex = pNode->uNext;
+            }
+        }
+        for(i = 0; i < pStack->uChunkCount; ++i)
+            free(pStack->apChunk[i]);
+        LockClose(pStack->pLock);
+        free(pStack);
+    }
+}
+
+/*
+ * push data into lock-free stack, and the data can be NULL
+ * @param LFSTACK *pStack
+ * @param void *pData
+ * @return INT -- return CAPI_SUCCESS or CAPI_FAILED
+ */
+INT LFStack_Push(LFSTACK *pStack, void *pData)
+{
+    LFSTACKNODE *pNode;
+    UINT uIndex;
+    if(NULL == pStack)
+        return CAPI_FAILED;
+    uIndex = LFStack_PopNode(pStack, &pStack->uFreeHead);
+    while(LFSTACK_NULL == uIndex)
+    {
+        if(LFStack_AddChunk(pStack) != CAPI_SUCCESS)
+            return CAPI_FAILED;
+        uIndex = LFStack_PopNode(pStack, &pStack->uFreeHead);
+    }
+    pNode = LFStack_GetNode(pStack, uIndex);
+    pNode->pData = pData;
+    LFStack_PushNode(&pStack->uHead, uIndex, pNode);
+    return CAPI_SUCCESS;
+}
+
+/*
+ * pop top data in lock-free stack
+ * @param LFSTACK *pStack
+ * @return void * -- return top stack data successfully or return NULL
+ */
+void *LFStack_Pop(LFSTACK *pStack)
+{
+    LFSTACKNODE *pNode;
+    void *pData;
+    UINT uIndex;
+    if(NULL == pStack)
+        return NULL;
+    uIndex = LFStack_PopNode(pStack, &pStack->uHead);
+    if(LFSTACK_NULL == uIndex)
+        return NULL;
+    pNode = LFStack_GetNode(pStack, uIndex);
+    pData = pNode->pData;
+    LFStack_PushNode(&pStack->uFreeHead, uIndex, pNode);
+    return pData;
+}
+
+/*
+ * check stack is empty or not
+ * @param LFSTACK *pStack
+ * @return INT -- 0 means empty, 1 means non-empty
+ */
+INT LFStack_IsEmpty(LFSTACK *pStack)
+{
+    return LFSTACK_INDEX(AtomicLoad64(&pStack->uHead)) != LFSTACK_NULL;
+}
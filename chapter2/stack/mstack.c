@@ -5,13 +5,9 @@
  * Description: Multi-tasks stack program
 **********************************************************************************/
 
+#pragma once
 #include "algo.h"
-
-typedef struct STACK_st{
-    void **ppBase;
-    UINT uTop;
-    unsigned int uStackSize;
-}STACK;
+#include "stack.c"
 
 typedef struct MSTACK_st{
     STACK *pStack;
@@ -35,7 +31,7 @@ MSTACK *MSTACK_Create(UINT uStackSize)
             pMStack->pLock = LockCreate();
             if(pMStack->pLock != NULL)
                 return pMStack;
-            free(pMStack->pLock);
+            Stack_Destroy(pMStack->pStack, NULL);
         }
         free(pMStack);
     }
@@ -5,6 +5,7 @@
  * Description: stack program
 **********************************************************************************/
 
+#pragma once
 #include "algo.h"
 
 typedef struct STACK_st{
@@ -62,8 +63,9 @@ void Stack_Destroy(STACK *pStack,DESTROYFUNC DestroyFunc)
                     (*DestroyFunc)(pStack->ppBase[i]);
                 }
             }
-            free(pStack->ppBase);
         }
+        free(pStack->ppBase);
+        free(pStack);
     }
 }
 